@@ -0,0 +1,26 @@
+// Heap allocation accounting: replaces the global operator new to count
+// allocations per thread. Linked into profiling builds and the benchmarks
+// only, so other programs using the simulator keep the standard allocator.
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+static thread_local uint64_t thread_allocations = 0;
+
+uint64_t allocationCount() { return thread_allocations; }
+
+// The replacements stay out of line so the compiler does not pair an inlined
+// malloc() or free() with the allocator calls (-Wmismatched-new-delete)
+
+__attribute__((noinline)) void* operator new(size_t size) {
+    thread_allocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { free(p); }
@@ -0,0 +1,11 @@
+// Console front end of the Factory Maintenance Optimization Simulator.
+
+#include "Menu.h"
+
+using namespace std;
+
+int main() {
+    ConsoleMenu menu;
+    menu.mainMenu();
+    return 0;
+}
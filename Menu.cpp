@@ -0,0 +1,768 @@
+#include "Menu.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+// ------------------- Helper input functions -------------------
+
+void ignoreLine() {
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+}
+
+int getIntInput(const string& prompt, int minVal, int maxVal) {
+    int val;
+    while (true) {
+        cout << prompt;
+        if (!(cin >> val)) {
+            cout << "Invalid input. Please enter an integer.\n";
+            cin.clear();
+            ignoreLine();
+            continue;
+        }
+        if (val < minVal || val > maxVal) {
+            cout << "Input must be between " << minVal << " and " << maxVal << ".\n";
+            ignoreLine();
+            continue;
+        }
+        ignoreLine();
+        return val;
+    }
+}
+
+double getDoubleInput(const string& prompt, double minVal, double maxVal) {
+    double val;
+    while (true) {
+        cout << prompt;
+        if (!(cin >> val)) {
+            cout << "Invalid input. Please enter a number.\n";
+            cin.clear();
+            ignoreLine();
+            continue;
+        }
+        if (val < minVal || val > maxVal) {
+            cout << "Input must be between " << minVal << " and " << maxVal << ".\n";
+            ignoreLine();
+            continue;
+        }
+        ignoreLine();
+        return val;
+    }
+}
+
+string getOptionalString(const string& prompt) {
+    string s;
+    cout << prompt;
+    getline(cin, s);
+    return s;
+}
+
+string getNonEmptyString(const string& prompt) {
+    string s;
+    while (true) {
+        cout << prompt;
+        getline(cin, s);
+        if (s.empty()) {
+            cout << "Input cannot be empty. Try again.\n";
+            continue;
+        }
+        return s;
+    }
+}
+
+void ConsoleMenu::addMachineType() {
+    cout << "\n-- Add Machine Type --\n";
+    string name = getNonEmptyString("Enter machine type name: ");
+    for (const auto& mt : scenario.machine_types) {
+        if (mt.name == name) {
+            cout << "Machine type with this name already exists.\n";
+            return;
+        }
+    }
+    int mttf = getIntInput("Enter MTTF (days) (>=1): ", 1, 10000);
+    int repair_time = getIntInput("Enter Repair Time (days) (>=1): ", 1, 10000);
+    int quantity = getIntInput("Enter Quantity (1-1000): ", 1, 1000);
+
+    scenario.addMachineType(name, mttf, repair_time, quantity);
+    cout << "Machine type \"" << name << "\" added successfully.\n";
+}
+
+vector<string> ConsoleMenu::selectMachineTypes(const string& purpose) {
+    cout << "Available machine types:\n";
+    for (size_t i = 0; i < scenario.machine_types.size(); ++i) {
+        cout << i + 1 << ". " << scenario.machine_types[i].name << "\n";
+    }
+    cout << "Select machine types " << purpose << " (enter numbers separated by space):\n";
+
+    vector<string> selected_machines;
+    while (true) {
+        cout << "Selection: ";
+        string line;
+        getline(cin, line);
+
+        selected_machines.clear();
+        size_t pos = 0;
+        try {
+            while (pos < line.size()) {
+                while (pos < line.size() && isspace(line[pos])) ++pos;
+                if (pos >= line.size()) break;
+                size_t endpos = pos;
+                while (endpos < line.size() && !isspace(line[endpos])) ++endpos;
+                string token = line.substr(pos, endpos - pos);
+                int sel = stoi(token);
+                if (sel < 1 || sel >(int)scenario.machine_types.size()) throw invalid_argument("Invalid number");
+                string m_name = scenario.machine_types[sel - 1].name;
+                if (!contains(selected_machines, m_name)) selected_machines.push_back(m_name);
+                pos = endpos;
+            }
+            if (selected_machines.empty()) throw invalid_argument("Empty selection");
+            break;
+        }
+        catch (const exception&) {
+            cout << "Invalid selection. Try again.\n";
+        }
+    }
+    return selected_machines;
+}
+
+void ConsoleMenu::addAdjusterGroup(bool on_call) {
+    if (scenario.machine_types.empty()) {
+        cout << "Add at least one machine type before adding adjusters.\n";
+        return;
+    }
+    cout << (on_call ? "\n-- Add On-Call Contractors --\n" : "\n-- Add Adjuster Group --\n");
+    string id = getNonEmptyString("Enter Adjuster Group ID: ");
+    for (const auto& ag : scenario.adjuster_groups) {
+        if (ag.id == id) {
+            cout << "Adjuster group with this ID already exists.\n";
+            return;
+        }
+    }
+    int count = getIntInput("Enter Number of Adjusters (1-1000): ", 1, 1000);
+
+    vector<string> selected_machines = selectMachineTypes("serviced by this adjuster group");
+
+    AdjusterGroup& ag = scenario.addAdjusterGroup(id, count, selected_machines);
+    string skill_line = getOptionalString("Enter skills of this group (separated by space, blank for none): ");
+    size_t pos = 0;
+    while (pos < skill_line.size()) {
+        while (pos < skill_line.size() && isspace(skill_line[pos])) ++pos;
+        size_t endpos = pos;
+        while (endpos < skill_line.size() && !isspace(skill_line[endpos])) ++endpos;
+        if (endpos > pos) ag.skills.push_back(skill_line.substr(pos, endpos - pos));
+        pos = endpos;
+    }
+    if (scenario.zones.size() > 1) {
+        cout << "Zones:\n";
+        for (size_t z = 0; z < scenario.zones.size(); ++z) {
+            cout << z + 1 << ". " << scenario.zones[z].name << "\n";
+        }
+        ag.home_zone = getIntInput("Select home zone of this group: ", 1, (int)scenario.zones.size()) - 1;
+    }
+    if (on_call) {
+        ag.on_call = true;
+        ag.call_in_queue = getIntInput("Call in when the repair queue is longer than (0-100000): ", 0, 100000);
+        ag.call_in_days = getIntInput("...for at least this many days (1-365): ", 1, 365);
+        ag.release_queue = getIntInput("Release when the queue is at most (0-" + to_string(ag.call_in_queue) + "): ", 0, ag.call_in_queue);
+        ag.release_days = getIntInput("...for at least this many days (1-365): ", 1, 365);
+        ag.day_rate = getDoubleInput("Cost per contractor per day called in: ", 0.0, 1e9);
+    }
+    cout << "Adjuster group \"" << id << "\" added successfully.\n";
+}
+
+void ConsoleMenu::addZone() {
+    cout << "\n-- Add Zone --\n";
+    string name = getNonEmptyString("Enter zone name: ");
+    for (const auto& z : scenario.zones) {
+        if (z.name == name) {
+            cout << "Zone with this name already exists.\n";
+            return;
+        }
+    }
+
+    vector<double> travel_hours;
+    for (const auto& other : scenario.zones) {
+        travel_hours.push_back(getDoubleInput("Travel time to " + other.name + " (hours): ", 0.0, 1000.0));
+    }
+    scenario.addZone(name, travel_hours);
+
+    if (scenario.zones.size() == 1) {
+        cout << "Zone \"" << name << "\" added. Machines and adjusters are placed here unless assigned elsewhere.\n";
+    }
+    else {
+        cout << "Zone \"" << name << "\" added successfully.\n";
+    }
+}
+
+void ConsoleMenu::addFailureDependency() {
+    if (scenario.machine_types.empty()) {
+        cout << "Add at least one machine type before adding failure dependencies.\n";
+        return;
+    }
+    cout << "\n-- Common-Cause and Cascading Failures --\n";
+    cout << "1. Add common-cause shock\n2. Add cascade rule\n3. Back\n";
+    int choice = getIntInput("Select option: ", 1, 3);
+    if (choice == 1) {
+        string name = getNonEmptyString("Enter shock name: ");
+        double interval = getDoubleInput("Mean days between shocks: ", 1.0, 100000.0);
+        double probability = getDoubleInput("Chance each working machine fails in a shock (0-1): ", 0.000001, 1.0);
+        vector<string> types = selectMachineTypes("hit by this shock");
+        scenario.addShockRule(ShockRule(name, interval, probability, types));
+        cout << "Shock \"" << name << "\" added successfully.\n";
+    }
+    else if (choice == 2) {
+        cout << "Machine types:\n";
+        for (size_t i = 0; i < scenario.machine_types.size(); ++i) {
+            cout << i + 1 << ". " << scenario.machine_types[i].name << "\n";
+        }
+        int trigger = getIntInput("Select machine type whose failure triggers the cascade: ", 1, (int)scenario.machine_types.size());
+        int dependent = getIntInput("Select machine type that is stressed: ", 1, (int)scenario.machine_types.size());
+        double factor = getDoubleInput("Hazard multiplier on stressed machines (>1): ", 1.0, 1000.0);
+        int duration = getIntInput("Days the stress lasts (1-365): ", 1, 365);
+        scenario.addCascadeRule(CascadeRule(scenario.machine_types[trigger - 1].name, scenario.machine_types[dependent - 1].name, factor, duration));
+        cout << "Cascade rule added successfully.\n";
+    }
+}
+
+void ConsoleMenu::configureMachineType() {
+    if (scenario.machine_types.empty()) {
+        cout << "No machine types.\n";
+        return;
+    }
+    cout << "\n-- Configure Machine Type --\n";
+    for (size_t i = 0; i < scenario.machine_types.size(); ++i) {
+        cout << i + 1 << ". " << scenario.machine_types[i].name << "\n";
+    }
+    int sel = getIntInput("Select machine type: ", 1, (int)scenario.machine_types.size());
+    MachineType& mt = scenario.machine_types[sel - 1];
+
+    while (true) {
+        cout << "\nConfigure " << mt.name << ":\n";
+        cout << "1. Criticality priority (current: " << mt.priority << ")\n";
+        cout << "2. Repair crew (current: " << mt.crew_size << " adjuster(s), up to " << mt.max_crew << ")\n";
+        cout << "3. Machine locations\n";
+        cout << "4. Ageing after repair (current: " << ageingModelName(mt.ageing_model) << ")\n";
+        cout << "5. Seasonal failure profile (current: "
+            << (mt.season.empty() ? string("constant") : to_string(mt.season.days.size()) + " segments") << ")\n";
+        cout << "6. Failure modes (current: "
+            << (mt.failure_modes.empty() ? string("single mode") : to_string(mt.failure_modes.size()) + " modes") << ")\n";
+        cout << "7. Standby spares (current: " << mt.spares << ", switchover " << mt.switchover_days << " days)\n";
+        cout << "8. Back\n";
+        int choice = getIntInput("Select option: ", 1, 8);
+        if (choice == 8) break;
+        if (choice == 1) {
+            mt.priority = getIntInput("Enter priority (0 = lowest, 9 = most critical): ", 0, 9);
+        }
+        else if (choice == 2) {
+            mt.crew_size = getIntInput("Adjusters needed to start a repair (1-10): ", 1, 10);
+            mt.max_crew = getIntInput("Maximum adjusters per repair (" + to_string(mt.crew_size) + "-20): ", mt.crew_size, 20);
+            mt.crew_speedup.clear();
+            double last = 1.0;
+            for (int n = mt.crew_size + 1; n <= mt.max_crew; ++n) {
+                last = getDoubleInput("Work rate with " + to_string(n) + " adjusters (x the " + to_string(mt.crew_size)
+                    + "-adjuster rate): ", last, 100.0);
+                mt.crew_speedup.push_back(last);
+            }
+        }
+        else if (choice == 3) {
+            configureMachineLocations(mt);
+        }
+        else if (choice == 4) {
+            configureAgeing(mt);
+        }
+        else if (choice == 5) {
+            configureSeason(mt);
+        }
+        else if (choice == 6) {
+            configureFailureModes(mt);
+        }
+        else if (choice == 7) {
+            mt.spares = getIntInput("Spare units on the shelf (0-1000): ", 0, 1000);
+            if (mt.spares > 0) mt.switchover_days = getIntInput("Days to switch a spare in (0-365): ", 0, 365);
+        }
+    }
+}
+
+void ConsoleMenu::configureMachineLocations(MachineType& mt) {
+    if (scenario.zones.size() < 2) {
+        cout << "Add at least two zones before placing machines.\n";
+        return;
+    }
+    if ((int)mt.machine_zones.size() != mt.quantity) mt.machine_zones.assign(mt.quantity, 0);
+
+    while (true) {
+        cout << "Zones:\n";
+        for (size_t z = 0; z < scenario.zones.size(); ++z) {
+            int placed = (int)count(mt.machine_zones.begin(), mt.machine_zones.end(), (int)z);
+            cout << z + 1 << ". " << scenario.zones[z].name << " (" << placed << " machines)\n";
+        }
+        int z = getIntInput("Select zone to place machines in (0 = done): ", 0, (int)scenario.zones.size());
+        if (z == 0) break;
+        int first = getIntInput("First machine number (1-" + to_string(mt.quantity) + "): ", 1, mt.quantity);
+        int max_count = mt.quantity - first + 1;
+        int n = getIntInput("Number of machines (1-" + to_string(max_count) + "): ", 1, max_count);
+        fill(mt.machine_zones.begin() + (first - 1), mt.machine_zones.begin() + (first - 1 + n), z - 1);
+    }
+}
+
+string ConsoleMenu::ageingModelName(AgeingModel model) {
+    switch (model) {
+    case AGEING_KIJIMA_I: return "Kijima type I";
+    case AGEING_KIJIMA_II: return "Kijima type II";
+    case AGEING_HAZARD_MULTIPLIER: return "hazard multiplier per repair";
+    default: return "as good as new";
+    }
+}
+
+void ConsoleMenu::configureAgeing(MachineType& mt) {
+    cout << "Ageing models:\n";
+    cout << "1. As good as new after repair\n";
+    cout << "2. Kijima type I (repair removes part of the last run's age)\n";
+    cout << "3. Kijima type II (repair removes part of the total age)\n";
+    cout << "4. Hazard multiplier per repair\n";
+    int model = getIntInput("Select model: ", 1, 4);
+    mt.ageing_model = (AgeingModel)(model - 1);
+    if (mt.ageing_model == AGEING_NONE) return;
+
+    mt.weibull_shape = getDoubleInput("Weibull shape (1 = constant hazard, >1 = wear-out): ", 0.2, 10.0);
+    if (mt.ageing_model == AGEING_HAZARD_MULTIPLIER) {
+        mt.repair_effect = getDoubleInput("Hazard multiplier per repair (e.g. 1.05): ", 1.0, 10.0);
+    }
+    else {
+        if (mt.weibull_shape <= 1.0) {
+            cout << "Note: with a shape of 1 or less age does not raise the hazard.\n";
+        }
+        mt.repair_effect = getDoubleInput("Share of age kept after repair (0 = as good as new, 1 = as bad as old): ", 0.0, 1.0);
+    }
+}
+
+void ConsoleMenu::configureSeason(MachineType& mt) {
+    int segments = getIntInput("Number of profile segments (0 = constant failure rate, max 366): ", 0, 366);
+    IntensityProfile profile;
+    bool any_positive = false;
+    for (int i = 0; i < segments; ++i) {
+        profile.days.push_back(getIntInput("Segment " + to_string(i + 1) + " length (days): ", 1, 3650));
+        profile.factor.push_back(getDoubleInput("Segment " + to_string(i + 1) + " failure rate factor (1 = nominal): ", 0.0, 100.0));
+        if (profile.factor.back() > 0.0) any_positive = true;
+    }
+    if (segments > 0) {
+        if (!any_positive) {
+            cout << "At least one segment needs a positive factor. Profile not changed.\n";
+            return;
+        }
+        profile.repeats = getIntInput("Repeat the profile after the last segment? (1 = yes, 0 = no): ", 0, 1) == 1;
+        if (!profile.repeats && profile.factor.back() <= 0.0) {
+            cout << "Note: machines will not fail after the profile ends.\n";
+        }
+    }
+    mt.season = profile;
+}
+
+void ConsoleMenu::configureFailureModes(MachineType& mt) {
+    int count = getIntInput("Number of failure modes (0 = use the type's MTTF and repair time, max 20): ", 0, 20);
+    mt.failure_modes.clear();
+    for (int i = 0; i < count; ++i) {
+        cout << "Failure mode " << i + 1 << ":\n";
+        string name = getNonEmptyString("  Name: ");
+        int mttf = getIntInput("  MTTF for this mode (days) (>=1): ", 1, 100000);
+        int repair = getIntInput("  Repair time (days) (>=1): ", 1, 10000);
+        string skill = getOptionalString("  Required skill (blank = any group servicing " + mt.name + "): ");
+        mt.failure_modes.emplace_back(name, mttf, repair, skill);
+    }
+    if (count > 0) {
+        cout << "The modes replace the type's MTTF and repair time.\n";
+    }
+}
+
+void ConsoleMenu::addProductionLine() {
+    if (scenario.machine_types.empty()) {
+        cout << "Add at least one machine type before adding production lines.\n";
+        return;
+    }
+    cout << "\n-- Add Production Line --\n";
+    string name = getNonEmptyString("Enter production line name: ");
+    for (const auto& pl : scenario.production_lines) {
+        if (pl.name == name) {
+            cout << "Production line with this name already exists.\n";
+            return;
+        }
+    }
+    int throughput = getIntInput("Enter output per day (units) (>=1): ", 1, 1000000);
+    int stage_count = getIntInput("Enter number of stages in series (1-50): ", 1, 50);
+
+    vector<LineStage> stages;
+    for (int s = 0; s < stage_count; ++s) {
+        cout << "\nStage " << s + 1 << " - available machine types:\n";
+        for (size_t i = 0; i < scenario.machine_types.size(); ++i) {
+            cout << i + 1 << ". " << scenario.machine_types[i].name << " (" << scenario.machine_types[i].quantity << " machines)\n";
+        }
+        int sel = getIntInput("Select machine type: ", 1, (int)scenario.machine_types.size());
+        const MachineType& mt = scenario.machine_types[sel - 1];
+
+        int first = getIntInput("First machine number in stage (1-" + to_string(mt.quantity) + "): ", 1, mt.quantity);
+        int max_count = mt.quantity - first + 1;
+        int count = getIntInput("Number of machines in stage (1-" + to_string(max_count) + "): ", 1, max_count);
+        int required = count;
+        if (count > 1) {
+            required = getIntInput("Machines required to run the stage (1-" + to_string(count) + "): ", 1, count);
+        }
+        stages.emplace_back(mt.name, first, count, required);
+    }
+
+    scenario.addProductionLine(name, throughput, stages);
+    cout << "Production line \"" << name << "\" added successfully.\n";
+}
+
+void ConsoleMenu::runSimulation() {
+    string error;
+    if (!validateScenario(scenario, error)) {
+        cout << "Cannot run: " << error << ".\n";
+        return;
+    }
+
+    int years = getIntInput("Enter number of years to simulate (>=1): ", 1, 1000);
+    int replications = getIntInput("Enter number of replications (1-1000): ", 1, 1000);
+
+    RunOptions options;
+    options.days = years * 365;
+    options.replications = replications;
+    options.threads = 0;
+
+    cout << "\nSimulation initialized:\n  Machine types: " << scenario.machine_types.size()
+        << "\n  Adjuster groups: " << scenario.adjuster_groups.size()
+        << "\n  Production lines: " << scenario.production_lines.size() << "\n";
+    cout << "\nStarting simulation for " << years << " year(s) (" << options.days << " days)";
+    if (replications > 1) cout << ", " << replications << " replications";
+    cout << "...\n";
+
+    if (!runScenario(scenario, options, results, error)) {
+        cout << "Error: " << error << "\n";
+        return;
+    }
+    has_results = true;
+
+#ifdef FMSS_PROFILE
+    if (TraceLog::instance().enabled()) {
+        if (TraceLog::instance().write()) cout << "Trace written to " << TraceLog::instance().outputPath() << "\n";
+        else cout << "Cannot write trace to " << TraceLog::instance().outputPath() << "\n";
+    }
+#endif
+
+    displayResults();
+}
+
+void ConsoleMenu::loadScenarioFile() {
+    cout << "\n-- Load Scenario File --\n";
+    string path = getNonEmptyString("Enter scenario file path: ");
+    ifstream file(path);
+    if (!file) {
+        cout << "Cannot open \"" << path << "\".\n";
+        return;
+    }
+    // The file replaces machine types and adjuster groups, and with them the
+    // lines and failure rules built on them; zones are kept
+    Scenario loaded;
+    string error;
+    if (!parseScenario(file, loaded, error)) {
+        cout << "Scenario not loaded: " << error << "\n";
+        return;
+    }
+    loaded.zones = scenario.zones;
+    scenario = move(loaded);
+    has_results = false;
+    cout << "Loaded " << scenario.machine_types.size() << " machine types and " << scenario.adjuster_groups.size() << " adjuster groups.\n";
+}
+
+// Tables for the first replication, then the spread over all of them
+void ConsoleMenu::displayResults() {
+    const RunResult& run = results.replications[0];
+    cout << "\n=== Simulation Results ===\n";
+    if (results.replications.size() > 1) cout << "(replication 1 of " << results.replications.size() << ", seed " << run.seed << ")\n";
+
+    cout << "\nMachine Utilization:\n";
+    cout << left << setw(25) << "Machine Type" << setw(15) << "Quantity" << setw(20) << "Estimated Uptime(%)" << "\n";
+    cout << string(60, '-') << "\n";
+    for (const MachineTypeResult& t : run.machine_types) {
+        cout << left << setw(25) << t.name << setw(15) << t.quantity << setw(20) << fixed << setprecision(2) << t.uptime << "\n";
+    }
+    cout << "\nOverall machine utilization: " << fixed << setprecision(2) << run.machine_uptime << "%\n";
+
+    if (!run.lines.empty()) displayLineResults(run);
+
+    cout << "\nAdjuster Utilization:\n";
+    cout << left << setw(15) << "Adjuster ID" << setw(15) << "Count" << setw(25) << "Estimated Utilization(%)" << "\n";
+    cout << string(60, '-') << "\n";
+    for (const AdjusterGroupResult& a : run.adjuster_groups) {
+        cout << left << setw(15) << a.id << setw(15) << a.count << setw(25) << fixed << setprecision(2) << a.utilization << "\n";
+    }
+    cout << "\nOverall adjuster utilization: " << fixed << setprecision(2) << run.adjuster_utilization << "%\n";
+
+    bool on_call = false;
+    for (const AdjusterGroup& ag : scenario.adjuster_groups) on_call = on_call || ag.on_call;
+    if (on_call) {
+        cout << "\nOn-call contractors:\n";
+        cout << left << setw(15) << "Adjuster ID" << setw(12) << "Call-ins" << setw(15) << "Days active" << "Cost" << "\n";
+        cout << string(60, '-') << "\n";
+        for (size_t g = 0; g < run.adjuster_groups.size(); ++g) {
+            if (!scenario.adjuster_groups[g].on_call) continue;
+            const AdjusterGroupResult& a = run.adjuster_groups[g];
+            cout << left << setw(15) << a.id << setw(12) << a.call_ins << setw(15) << a.available_days
+                << fixed << setprecision(2) << a.cost << "\n";
+        }
+        cout << "Total contractor cost: " << fixed << setprecision(2) << run.contractor_cost << "\n";
+    }
+
+    if (scenario.zones.size() > 1) {
+        long long busy_days = 0;
+        for (const AdjusterGroupResult& a : run.adjuster_groups) busy_days += a.busy_days;
+        double share = busy_days > 0 ? 100.0 * run.travel_days / busy_days : 0;
+        cout << "Adjuster travel between zones: " << fixed << setprecision(1) << run.travel_days
+            << " days (" << setprecision(2) << share << "% of busy time)\n";
+    }
+
+    cout << "\nRepairs completed: " << run.repairs_completed << "\n";
+    cout << "Max repair queue length during simulation: " << run.max_queue_length << "\n";
+    bool priorities = false;
+    for (const MachineType& mt : scenario.machine_types) priorities = priorities || mt.priority > 0;
+    if (priorities) {
+        cout << "Repairs preempted by more critical failures: " << run.preemptions << "\n";
+    }
+    if (!scenario.shock_rules.empty()) {
+        cout << "Common-cause shocks: " << run.shocks << " (" << run.shock_failures << " machine failures)\n";
+    }
+    if (!scenario.cascade_rules.empty()) {
+        cout << "Failures brought forward by cascades: " << run.cascade_hazard_raises << "\n";
+    }
+    if (run.spare_swaps > 0) {
+        cout << "Standby spares swapped in: " << run.spare_swaps << "\n";
+    }
+
+    // Show timeline summary (last 10 events)
+    cout << "\nRecent Simulation Events (last 10):\n";
+    for (const TimelineEntry& ev : run.recent_events) {
+        cout << "Day " << ev.day << ": " << ev.text << "\n";
+    }
+
+    if (results.replications.size() > 1) displayReplicationSummary();
+
+#ifdef FMSS_PROFILE
+    displayProfile(run);
+#endif
+
+    // Detail viewing menu
+    while (true) {
+        cout << "\nView Details:\n1. Machine Types\n2. Adjuster Groups\n3. Exit\n";
+        int choice = getIntInput("Select option: ", 1, 3);
+        if (choice == 3) break;
+        if (choice == 1) showMachineDetails();
+        else if (choice == 2) showAdjusterDetails();
+    }
+}
+
+void ConsoleMenu::displayLineResults(const RunResult& run) {
+    cout << "\nProduction Line Availability:\n";
+    cout << left << setw(20) << "Line" << setw(10) << "Stages" << setw(18) << "Availability(%)"
+        << setw(12) << "Stoppages" << setw(15) << "Output" << "Lost Output" << "\n";
+    cout << string(85, '-') << "\n";
+    for (const LineResult& l : run.lines) {
+        cout << left << setw(20) << l.name << setw(10) << l.stages << setw(18) << fixed << setprecision(2) << l.availability
+            << setw(12) << l.stoppages << setw(15) << l.output << l.lost_output << "\n";
+    }
+
+    cout << "\nPlant output: " << run.plant_output << " units (lost to downtime: " << run.plant_lost << ")\n";
+    cout << "Max production lines down at once: " << run.max_lines_down << "\n";
+}
+
+void ConsoleMenu::displayReplicationSummary() {
+    cout << "\nAcross " << results.replications.size() << " replications:\n";
+    cout << left << setw(28) << "Metric" << setw(12) << "Mean" << setw(12) << "Std dev" << setw(12) << "Min" << "Max" << "\n";
+    cout << string(72, '-') << "\n";
+    auto row = [](const string& name, const MetricSummary& m) {
+        cout << left << setw(28) << name << fixed << setprecision(2) << setw(12) << m.mean << setw(12) << m.stdev
+            << setw(12) << m.min << m.max << "\n";
+    };
+    row("Machine utilization (%)", results.machine_uptime);
+    row("Adjuster utilization (%)", results.adjuster_utilization);
+    row("Repairs completed", results.repairs_completed);
+    row("Max repair queue length", results.max_queue_length);
+}
+
+#ifdef FMSS_PROFILE
+void ConsoleMenu::displayProfile(const RunResult& run) {
+    static const char* phase_names[] = {
+        "Staffing", "Dispatch", "Machine updates", "Shocks", "Adjuster updates",
+        "Team repairs", "Switchovers", "Day record"
+    };
+    const Profile& profile = run.profile;
+    double ns_per_tick = profile.nsPerTick();
+    double total_ms = (double)chrono::duration_cast<chrono::microseconds>(profile.end_time - profile.start_time).count() / 1000.0;
+    uint64_t events = profile.counters[COUNT_EVENTS];
+
+    cout << "\nProfile (" << fixed << setprecision(1) << total_ms << " ms over " << run.days << " days):\n";
+    cout << left << setw(20) << "Phase" << setw(12) << "Time(ms)" << setw(10) << "Share(%)" << setw(12) << "Calls"
+        << setw(12) << "ns/day" << "Allocations" << "\n";
+    cout << string(78, '-') << "\n";
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        if (profile.calls[p] == 0) continue;
+        double ms = profile.ticks[p] * ns_per_tick / 1e6;
+        cout << left << setw(20) << phase_names[p] << setw(12) << setprecision(2) << ms
+            << setw(10) << (total_ms > 0 ? 100.0 * ms / total_ms : 0.0) << setw(12) << profile.calls[p]
+            << setw(12) << setprecision(0) << ms * 1e6 / max(run.days, 1) << profile.allocations[p] << "\n";
+    }
+    cout << "Events processed: " << events;
+    if (events > 0) cout << " (" << setprecision(0) << total_ms * 1e6 / events << " ns per event)";
+    cout << "\nQueue re-pushes in dispatch: " << profile.counters[COUNT_REQUEUES] << "\n";
+    uint64_t allocations = profile.end_allocations - profile.start_allocations;
+    cout << "Heap allocations: " << allocations;
+    if (events > 0) cout << " (" << setprecision(3) << (double)allocations / events << " per event)";
+    cout << "\n";
+    if (run.perf_enabled) displayPerfCounters(run, events);
+}
+
+void ConsoleMenu::displayPerfCounters(const RunResult& run, uint64_t events) {
+    static const char* names[] = { "Cycles", "Instructions", "Cache misses", "Branch misses" };
+    cout << "\nHardware counters (user space):\n";
+    bool any = false;
+    for (int k = 0; k < PERF_KIND_COUNT; ++k) {
+        double v = run.perf[k];
+        if (v < 0) continue;
+        any = true;
+        cout << left << setw(16) << names[k] << setw(18) << setprecision(0) << v;
+        if (events > 0) cout << setprecision(1) << v / events << " per event";
+        cout << "\n";
+    }
+    if (!any) {
+        cout << "Unavailable (" << (run.perf_error.empty() ? "no counters read" : run.perf_error) << ")\n";
+        return;
+    }
+    double cycles = run.perf[PERF_CYCLES], instructions = run.perf[PERF_INSTRUCTIONS];
+    if (cycles > 0 && instructions >= 0) cout << "IPC: " << setprecision(2) << instructions / cycles << "\n";
+}
+#endif
+
+void ConsoleMenu::showMachineDetails() {
+    if (scenario.machine_types.empty()) {
+        cout << "No machine types.\n";
+        return;
+    }
+    cout << "Machine Types:\n";
+    for (size_t i = 0; i < scenario.machine_types.size(); ++i) {
+        cout << i + 1 << ". " << scenario.machine_types[i].name << "\n";
+    }
+    int sel = getIntInput("Select machine type: ", 1, (int)scenario.machine_types.size());
+    size_t idx = sel - 1;
+    const MachineType& mt = scenario.machine_types[idx];
+
+    cout << "\nDetails of machine: " << mt.name << "\n";
+    cout << "MTTF (days): " << mt.MTTF_days << "\n";
+    cout << "Repair time (days): " << mt.repair_time << "\n";
+    cout << "Quantity: " << mt.quantity << "\n";
+    cout << "Criticality priority: " << mt.priority << "\n";
+    if (mt.usesTeams()) {
+        cout << "Repair crew: " << mt.crew_size << " adjuster(s), up to " << mt.max_crew << "\n";
+    }
+
+    if (!has_results) {
+        cout << "No simulation results yet.\n";
+        return;
+    }
+    const MachineTypeResult& t = results.replications[0].machine_types[idx];
+    cout << "Currently working: " << t.working << "\n";
+    cout << "Currently broken/repairing: " << t.broken << "\n";
+
+    if (mt.spares > 0) {
+        cout << "Standby spares: " << mt.spares << " (switchover " << mt.switchover_days << " days)"
+            << ", on shelf now: " << t.spares_on_shelf << ", swaps: " << t.spare_swaps << "\n";
+    }
+
+    if (!mt.failure_modes.empty()) {
+        cout << "Failure modes:\n";
+        for (size_t f = 0; f < mt.failure_modes.size(); ++f) {
+            const FailureMode& fm = mt.failure_modes[f];
+            cout << "  - " << fm.name << ": MTTF " << fm.MTTF_days << " days, repair " << fm.repair_time << " days"
+                << (fm.skill.empty() ? string() : ", needs " + fm.skill)
+                << ", failures: " << (f < t.mode_failures.size() ? t.mode_failures[f] : 0) << "\n";
+        }
+    }
+
+    if (!mt.season.empty()) {
+        int period = 0;
+        for (int d : mt.season.days) period += d;
+        cout << "Seasonal failure profile: " << mt.season.days.size() << " segments over " << period << " days"
+            << (mt.season.repeats ? " (repeating)" : "") << "\n";
+    }
+
+    if (mt.ageing_model != AGEING_NONE) {
+        cout << "Ageing model: " << ageingModelName(mt.ageing_model) << " (Weibull shape " << mt.weibull_shape << ")\n";
+        cout << "Average failures per machine: " << fixed << setprecision(2) << t.failures_per_machine << "\n";
+        if (mt.ageing_model != AGEING_HAZARD_MULTIPLIER) {
+            cout << "Average virtual age (days): " << fixed << setprecision(1) << t.mean_virtual_age << "\n";
+        }
+    }
+}
+
+void ConsoleMenu::showAdjusterDetails() {
+    if (scenario.adjuster_groups.empty()) {
+        cout << "No adjuster groups.\n";
+        return;
+    }
+    cout << "Adjuster Groups:\n";
+    for (size_t i = 0; i < scenario.adjuster_groups.size(); ++i) {
+        cout << i + 1 << ". " << scenario.adjuster_groups[i].id << "\n";
+    }
+    int sel = getIntInput("Select adjuster group: ", 1, (int)scenario.adjuster_groups.size());
+    size_t idx = sel - 1;
+    const AdjusterGroup& ag = scenario.adjuster_groups[idx];
+
+    cout << "\nAdjuster Group: " << ag.id << "\n";
+    cout << "Count: " << ag.count << "\n";
+    cout << "Services machine types:\n";
+    for (const string& m : ag.capable_machines) {
+        cout << "  - " << m << "\n";
+    }
+    if (!ag.skills.empty()) {
+        cout << "Skills:";
+        for (const string& sk : ag.skills) cout << " " << sk;
+        cout << "\n";
+    }
+
+    if (!has_results) {
+        cout << "No simulation results yet.\n";
+        return;
+    }
+    const AdjusterGroupResult& a = results.replications[0].adjuster_groups[idx];
+    cout << "Currently busy: " << a.busy << "\n";
+    cout << "Currently idle: " << a.count - a.busy << "\n";
+}
+
+void ConsoleMenu::mainMenu() {
+    while (true) {
+        cout << "\n=== Factory Maintenance Optimization Simulator ===\n";
+        cout << "1. Add Machine Type\n";
+        cout << "2. Configure Machine Type\n";
+        cout << "3. Add Adjuster Group\n";
+        cout << "4. Add On-Call Contractors\n";
+        cout << "5. Add Production Line\n";
+        cout << "6. Add Zone\n";
+        cout << "7. Common-Cause and Cascading Failures\n";
+        cout << "8. Load Scenario File\n";
+        cout << "9. Run Simulation\n";
+        cout << "10. Exit\n";
+
+        int choice = getIntInput("Select option: ", 1, 10);
+        switch (choice) {
+        case 1: addMachineType(); break;
+        case 2: configureMachineType(); break;
+        case 3: addAdjusterGroup(); break;
+        case 4: addAdjusterGroup(true); break;
+        case 5: addProductionLine(); break;
+        case 6: addZone(); break;
+        case 7: addFailureDependency(); break;
+        case 8: loadScenarioFile(); break;
+        case 9: runSimulation(); break;
+        case 10: cout << "Goodbye!\n"; return;
+        }
+    }
+}
@@ -0,0 +1,53 @@
+// Console menus of the Factory Maintenance Optimization Simulator: builds a
+// Scenario from prompts or a scenario file, runs it through runScenario and
+// prints the results. All console I/O of the program lives here.
+
+#pragma once
+
+#include "Simulator.h"
+
+// ------------------- Helper input functions -------------------
+
+void ignoreLine();
+int getIntInput(const std::string& prompt, int minVal, int maxVal);
+double getDoubleInput(const std::string& prompt, double minVal, double maxVal);
+std::string getOptionalString(const std::string& prompt);
+std::string getNonEmptyString(const std::string& prompt);
+
+// ------------------- Console Menu -------------------
+
+class ConsoleMenu {
+public:
+    void mainMenu();
+
+private:
+    Scenario scenario;
+    Results results;            // of the last run
+    bool has_results = false;   // cleared when a scenario file replaces the factory
+
+    void addMachineType();
+    std::vector<std::string> selectMachineTypes(const std::string& purpose);
+    void addAdjusterGroup(bool on_call = false);
+    void addZone();
+    void addFailureDependency();
+    void configureMachineType();
+    void configureMachineLocations(MachineType& mt);
+    void configureAgeing(MachineType& mt);
+    void configureSeason(MachineType& mt);
+    void configureFailureModes(MachineType& mt);
+    void addProductionLine();
+    void loadScenarioFile();
+    void runSimulation();
+
+    void displayResults();
+    void displayLineResults(const RunResult& run);
+    void displayReplicationSummary();
+#ifdef FMSS_PROFILE
+    void displayProfile(const RunResult& run);
+    void displayPerfCounters(const RunResult& run, uint64_t events);
+#endif
+    void showMachineDetails();
+    void showAdjusterDetails();
+
+    static std::string ageingModelName(AgeingModel model);
+};
@@ -1,564 +1,1604 @@
-#include <iostream>
-#include <string>
-#include <vector>
-#include <queue>
-#include <map>
-#include <limits>
-#include <iomanip>
-#include <stdexcept>
-#include <random>
-#include <algorithm>
+#include "Simulator.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
 using namespace std;
 
-// ----------- Structs and Classes ------------
-
-// Machine type info
-struct MachineType {
-    string name;
-    int MTTF_days;      // mean time to failure in days
-    int repair_time;    // repair days
-    int quantity;       // number of machines
-    MachineType() = default;
-    MachineType(const string& n, int m, int r, int q) : name(n), MTTF_days(m), repair_time(r), quantity(q) {}
-};
-
-// Machine instance for simulation
-struct MachineInstance {
-    int group_index;
-    int id_in_group;
-    bool working;            // true = working, false = broken/repair
-    int running_days;        // days machine worked since last repair/failure
-    int repair_days;         // days spent repairing so far
-    int failure_day;         // day count until next failure (randomized)
-
-    MachineInstance(int group, int id)
-        : group_index(group), id_in_group(id), working(true),
-          running_days(0), repair_days(0), failure_day(-1) {}
-};
-
-// Adjuster group info
-struct AdjusterGroup {
-    string id;
-    int count;
-    vector<string> capable_machines; // machine types the group can service
-
-    AdjusterGroup() = default;
-    AdjusterGroup(const string& i, int c, const vector<string>& caps) : id(i), count(c), capable_machines(caps) {}
-};
-
-// Adjuster instance for simulation
-struct AdjusterInstance {
-    int group_index;
-    int id_in_group;
-    bool busy;
-    int days_worked;            // days spent working on current repair
-    int required_days;          // total repair days required for current job
-    MachineInstance* current_machine;  // pointer to machine being repaired
-    int total_busy_days;
-
-    AdjusterInstance(int group_idx, int id)
-        : group_index(group_idx), id_in_group(id), busy(false),
-          days_worked(0), required_days(0), current_machine(nullptr), total_busy_days(0) {}
-};
-
-// Event for timeline logging
-struct TimelineEvent {
-    int day;
-    string description;
-    TimelineEvent(int d, const string& desc) : day(d), description(desc) {}
-};
-
-
-// ------------------- Helper input functions -------------------
-
-void ignoreLine() {
-    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-}
-
-int getIntInput(const string& prompt, int minVal, int maxVal) {
-    int val;
-    while (true) {
-        cout << prompt;
-        if (!(cin >> val)) {
-            cout << "Invalid input. Please enter an integer.\n";
-            cin.clear();
-            ignoreLine();
-            continue;
-        }
-        if (val < minVal || val > maxVal) {
-            cout << "Input must be between " << minVal << " and " << maxVal << ".\n";
-            ignoreLine();
-            continue;
-        }
-        ignoreLine();
-        return val;
-    }
-}
-
-string getNonEmptyString(const string& prompt) {
-    string s;
-    while (true) {
-        cout << prompt;
-        getline(cin, s);
-        if (s.empty()) {
-            cout << "Input cannot be empty. Try again.\n";
-            continue;
-        }
-        return s;
-    }
-}
+// ------------------- Helpers -------------------
 
 bool contains(const vector<string>& vec, const string& val) {
     return find(vec.begin(), vec.end(), val) != vec.end();
 }
 
-// ------------------- Simulator Class -------------------
+// ------------------- Scenario -------------------
 
-class FMSSimulator {
-private:
-    vector<MachineType> machine_types;
-    vector<AdjusterGroup> adjuster_groups;
-
-    vector<vector<MachineInstance>> machines; // per machine type group
-    vector<vector<AdjusterInstance>> adjusters; // per adjuster group
+MachineType& Scenario::addMachineType(const string& name, int mttf, int repair_time, int quantity) {
+    machine_types.emplace_back(name, mttf, repair_time, quantity);
+    return machine_types.back();
+}
 
-    queue<MachineInstance*> repair_queue;
+AdjusterGroup& Scenario::addAdjusterGroup(const string& id, int count, const vector<string>& capable_machines) {
+    adjuster_groups.emplace_back(id, count, capable_machines);
+    return adjuster_groups.back();
+}
 
-    int simulation_days = 0;
+Zone& Scenario::addZone(const string& name, const vector<double>& travel_hours) {
+    Zone zone(name);
+    for (size_t z = 0; z < zones.size(); ++z) {
+        double hours = z < travel_hours.size() ? travel_hours[z] : 0.0;
+        zone.travel_hours.push_back(hours);
+        zones[z].travel_hours.push_back(hours);
+    }
+    zone.travel_hours.push_back(0.0);
+    zones.push_back(zone);
+    return zones.back();
+}
 
-    // Random number generator
-    default_random_engine rng;
+ProductionLine& Scenario::addProductionLine(const string& name, int throughput, const vector<LineStage>& stages) {
+    production_lines.emplace_back(name, throughput, stages);
+    return production_lines.back();
+}
 
-    // Timeline events
-    vector<TimelineEvent> timeline;
+void Scenario::addShockRule(const ShockRule& rule) {
+    shock_rules.push_back(rule);
+}
 
-    // For max queue length tracking
-    int max_queue_length = 0;
+void Scenario::addCascadeRule(const CascadeRule& rule) {
+    cascade_rules.push_back(rule);
+}
 
-public:
-    FMSSimulator() {
-        rng.seed(random_device{}());
+int Scenario::machineTypeIndex(const string& name) const {
+    for (size_t i = 0; i < machine_types.size(); ++i) {
+        if (machine_types[i].name == name) return (int)i;
     }
+    return -1;
+}
 
-    void addMachineType() {
-        cout << "\n-- Add Machine Type --\n";
-        string name = getNonEmptyString("Enter machine type name: ");
-        for (const auto& mt : machine_types) {
-            if (mt.name == name) {
-                cout << "Machine type with this name already exists.\n";
-                return;
-            }
-        }
-        int mttf = getIntInput("Enter MTTF (days) (>=1): ", 1, 10000);
-        int repair_time = getIntInput("Enter Repair Time (days) (>=1): ", 1, 10000);
-        int quantity = getIntInput("Enter Quantity (1-1000): ", 1, 1000);
-
-        machine_types.emplace_back(name, mttf, repair_time, quantity);
-        cout << "Machine type \"" << name << "\" added successfully.\n";
+int Scenario::adjusterGroupIndex(const string& id) const {
+    for (size_t i = 0; i < adjuster_groups.size(); ++i) {
+        if (adjuster_groups[i].id == id) return (int)i;
     }
+    return -1;
+}
 
-    void addAdjusterGroup() {
-        if (machine_types.empty()) {
-            cout << "Add at least one machine type before adding adjusters.\n";
-            return;
-        }
-        cout << "\n-- Add Adjuster Group --\n";
-        string id = getNonEmptyString("Enter Adjuster Group ID: ");
-        for (const auto& ag : adjuster_groups) {
-            if (ag.id == id) {
-                cout << "Adjuster group with this ID already exists.\n";
-                return;
+// Scenario file format, one entry per line:
+//   machine_type <name> <MTTF days> <repair days> <quantity>
+//   adjuster_group <id> <count> <machine type>...
+// Blank lines and lines starting with # are ignored.
+bool parseScenario(istream& in, Scenario& scenario, string& error) {
+    Scenario parsed;
+    vector<MachineType>& types = parsed.machine_types;
+    vector<AdjusterGroup>& groups = parsed.adjuster_groups;
+    string line;
+    int line_no = 0;
+    while (getline(in, line)) {
+        ++line_no;
+        istringstream fields(line);
+        string kind;
+        if (!(fields >> kind) || kind[0] == '#') continue;
+        string name, extra;
+        if (kind == "machine_type") {
+            int mttf, repair_time, quantity;
+            if (!(fields >> name >> mttf >> repair_time >> quantity) || (fields >> extra)) {
+                error = "line " + to_string(line_no) + ": expected machine_type <name> <MTTF> <repair time> <quantity>";
+                return false;
+            }
+            if (mttf < 1 || repair_time < 1 || quantity < 1) {
+                error = "line " + to_string(line_no) + ": MTTF, repair time and quantity must be at least 1";
+                return false;
             }
+            if (parsed.machineTypeIndex(name) >= 0) {
+                error = "line " + to_string(line_no) + ": duplicate machine type \"" + name + "\"";
+                return false;
+            }
+            types.emplace_back(name, mttf, repair_time, quantity);
         }
-        int count = getIntInput("Enter Number of Adjusters (1-1000): ", 1, 1000);
-
-        cout << "Available machine types:\n";
-        for (size_t i = 0; i < machine_types.size(); ++i) {
-            cout << i + 1 << ". " << machine_types[i].name << "\n";
-        }
-        cout << "Select machine types serviced by this adjuster group (enter numbers separated by space):\n";
-
-        vector<string> selected_machines;
-        while (true) {
-            cout << "Selection: ";
-            string line;
-            getline(cin, line);
-
-            selected_machines.clear();
-            size_t pos = 0;
-            try {
-                while (pos < line.size()) {
-                    while (pos < line.size() && isspace(line[pos])) ++pos;
-                    if (pos >= line.size()) break;
-                    size_t endpos = pos;
-                    while (endpos < line.size() && !isspace(line[endpos])) ++endpos;
-                    string token = line.substr(pos, endpos - pos);
-                    int sel = stoi(token);
-                    if (sel < 1 || sel >(int)machine_types.size()) throw invalid_argument("Invalid number");
-                    string m_name = machine_types[sel - 1].name;
-                    if (!contains(selected_machines, m_name)) selected_machines.push_back(m_name);
-                    pos = endpos;
+        else if (kind == "adjuster_group") {
+            int count;
+            if (!(fields >> name >> count) || count < 1) {
+                error = "line " + to_string(line_no) + ": expected adjuster_group <id> <count> <machine type>...";
+                return false;
+            }
+            if (parsed.adjusterGroupIndex(name) >= 0) {
+                error = "line " + to_string(line_no) + ": duplicate adjuster group \"" + name + "\"";
+                return false;
+            }
+            vector<string> capable;
+            string type_name;
+            while (fields >> type_name) {
+                if (parsed.machineTypeIndex(type_name) < 0) {
+                    error = "line " + to_string(line_no) + ": unknown machine type \"" + type_name + "\"";
+                    return false;
                 }
-                if (selected_machines.empty()) throw invalid_argument("Empty selection");
-                break;
+                if (!contains(capable, type_name)) capable.push_back(type_name);
             }
-            catch (const exception&) {
-                cout << "Invalid selection. Try again.\n";
+            if (capable.empty()) {
+                error = "line " + to_string(line_no) + ": adjuster group \"" + name + "\" services no machine types";
+                return false;
             }
+            groups.emplace_back(name, count, capable);
         }
-
-        adjuster_groups.emplace_back(id, count, selected_machines);
-        cout << "Adjuster group \"" << id << "\" added successfully.\n";
+        else {
+            error = "line " + to_string(line_no) + ": unknown entry \"" + kind + "\"";
+            return false;
+        }
+    }
+    if (types.empty()) {
+        error = "scenario has no machine types";
+        return false;
     }
+    scenario = move(parsed);
+    return true;
+}
 
-    void initializeSimulation() {
-        machines.clear();
-        for (size_t i = 0; i < machine_types.size(); ++i) {
-            vector<MachineInstance> group;
-            for (int q = 0; q < machine_types[i].quantity; ++q) {
-                MachineInstance m(i, q);
-                // Assign randomized failure day
-                int fail_day = randomizedFailureDay(machine_types[i].MTTF_days);
-                m.failure_day = fail_day;
-                group.push_back(m);
+bool validateScenario(const Scenario& scenario, string& error) {
+    if (scenario.machine_types.empty()) {
+        error = "add at least one machine type";
+        return false;
+    }
+    if (scenario.adjuster_groups.empty()) {
+        error = "add at least one adjuster group";
+        return false;
+    }
+    int zone_count = max((int)scenario.zones.size(), 1);
+    for (size_t z = 0; z < scenario.zones.size(); ++z) {
+        const Zone& zone = scenario.zones[z];
+        string where = "zone \"" + zone.name + "\": ";
+        if (zone.travel_hours.size() != scenario.zones.size()) error = where + "needs a travel time to every zone";
+        else if (any_of(zone.travel_hours.begin(), zone.travel_hours.end(), [](double h) { return !(h >= 0.0) || isinf(h); })) {
+            error = where + "travel times must be finite and not negative";
+        }
+        else if (zone.travel_hours[z] != 0.0) error = where + "travel time to itself must be zero";
+        if (!error.empty()) return false;
+    }
+    for (size_t t = 0; t < scenario.machine_types.size(); ++t) {
+        const MachineType& mt = scenario.machine_types[t];
+        string where = "machine type \"" + mt.name + "\": ";
+        if (scenario.machineTypeIndex(mt.name) != (int)t) error = "duplicate machine type \"" + mt.name + "\"";
+        else if (mt.MTTF_days < 1 || mt.repair_time < 1 || mt.quantity < 1) error = where + "MTTF, repair time and quantity must be at least 1";
+        else if (mt.crew_size < 1 || mt.max_crew < mt.crew_size) error = where + "crew size must be at least 1 and at most the maximum crew";
+        else if ((int)mt.crew_speedup.size() != mt.max_crew - mt.crew_size) {
+            error = where + "needs a work rate for every crew size above the minimum";
+        }
+        else if (any_of(mt.crew_speedup.begin(), mt.crew_speedup.end(), [](double r) { return !(r > 0.0) || isinf(r); })) {
+            error = where + "crew work rates must be finite and positive";
+        }
+        else if (!mt.machine_zones.empty() && (int)mt.machine_zones.size() != mt.quantity) error = where + "needs a zone for every machine";
+        else if (any_of(mt.machine_zones.begin(), mt.machine_zones.end(), [&](int z) { return z < 0 || z >= zone_count; })) {
+            error = where + "machine placed in an unknown zone";
+        }
+        else if (!(mt.weibull_shape > 0.0)) error = where + "Weibull shape must be positive";
+        else if (mt.ageing_model == AGEING_HAZARD_MULTIPLIER && !(mt.repair_effect > 0.0)) error = where + "hazard multiplier must be positive";
+        else if ((mt.ageing_model == AGEING_KIJIMA_I || mt.ageing_model == AGEING_KIJIMA_II)
+            && !(mt.repair_effect >= 0.0 && mt.repair_effect <= 1.0)) {
+            error = where + "share of age kept after repair must be between 0 and 1";
+        }
+        else if (mt.season.days.size() != mt.season.factor.size()) error = where + "seasonal profile needs a factor for every segment";
+        else if (any_of(mt.season.days.begin(), mt.season.days.end(), [](int d) { return d < 1; })) {
+            error = where + "seasonal segments must last at least one day";
+        }
+        else if (any_of(mt.season.factor.begin(), mt.season.factor.end(), [](double f) { return !(f >= 0.0) || isinf(f); })) {
+            error = where + "seasonal factors must be finite and not negative";
+        }
+        else if (!mt.season.empty() && none_of(mt.season.factor.begin(), mt.season.factor.end(), [](double f) { return f > 0.0; })) {
+            error = where + "seasonal profile needs a segment with a positive factor";
+        }
+        else if (mt.spares < 0 || mt.switchover_days < 0) error = where + "spares and switchover days cannot be negative";
+        else {
+            for (const FailureMode& fm : mt.failure_modes) {
+                if (fm.MTTF_days < 1 || fm.repair_time < 1) error = where + "failure mode \"" + fm.name + "\" needs MTTF and repair time of at least 1";
             }
-            machines.push_back(move(group));
         }
-
-        adjusters.clear();
-        for (size_t i = 0; i < adjuster_groups.size(); ++i) {
-            vector<AdjusterInstance> group;
-            for (int q = 0; q < adjuster_groups[i].count; ++q) {
-                group.emplace_back(i, q);
+        if (!error.empty()) return false;
+    }
+    for (size_t g = 0; g < scenario.adjuster_groups.size(); ++g) {
+        const AdjusterGroup& ag = scenario.adjuster_groups[g];
+        string where = "adjuster group \"" + ag.id + "\": ";
+        if (scenario.adjusterGroupIndex(ag.id) != (int)g) error = "duplicate adjuster group \"" + ag.id + "\"";
+        else if (ag.count < 1) error = where + "needs at least one adjuster";
+        else if (ag.home_zone < 0 || ag.home_zone >= zone_count) error = where + "unknown home zone";
+        else if (ag.on_call && (ag.call_in_queue < 0 || ag.call_in_days < 0 || ag.release_days < 0)) {
+            error = where + "call-in threshold and call-in and release days cannot be negative";
+        }
+        else if (ag.on_call && ag.release_queue > ag.call_in_queue) error = where + "release threshold above the call-in threshold";
+        else if (ag.on_call && (!(ag.day_rate >= 0.0) || isinf(ag.day_rate))) error = where + "day rate must be finite and not negative";
+        else {
+            for (const string& name : ag.capable_machines) {
+                if (scenario.machineTypeIndex(name) < 0) error = where + "unknown machine type \"" + name + "\"";
             }
-            adjusters.push_back(move(group));
         }
-
-        while (!repair_queue.empty()) repair_queue.pop();
-        timeline.clear();
-        max_queue_length = 0;
-
-        cout << "\nSimulation initialized:\n  Machine types: " << machine_types.size()
-            << "\n  Adjuster groups: " << adjuster_groups.size() << "\n";
+        if (!error.empty()) return false;
+    }
+    for (const ProductionLine& pl : scenario.production_lines) {
+        for (const LineStage& st : pl.stages) {
+            int t = scenario.machineTypeIndex(st.machine_type);
+            if (t < 0) error = "production line \"" + pl.name + "\": unknown machine type \"" + st.machine_type + "\"";
+            else if (st.first_machine < 1 || st.count < 1 || st.first_machine + st.count - 1 > scenario.machine_types[t].quantity) {
+                error = "production line \"" + pl.name + "\": stage machines out of range";
+            }
+            else if (st.required < 1 || st.required > st.count) error = "production line \"" + pl.name + "\": required machines out of range";
+            if (!error.empty()) return false;
+        }
+    }
+    for (const ShockRule& rule : scenario.shock_rules) {
+        for (const string& name : rule.machine_types) {
+            if (scenario.machineTypeIndex(name) < 0) error = "shock \"" + rule.name + "\": unknown machine type \"" + name + "\"";
+        }
+        if (!(rule.mean_interval_days > 0.0) || !(rule.fail_probability > 0.0 && rule.fail_probability <= 1.0)) {
+            error = "shock \"" + rule.name + "\": interval must be positive and the failure chance in (0, 1]";
+        }
+        if (!error.empty()) return false;
+    }
+    for (const CascadeRule& rule : scenario.cascade_rules) {
+        if (scenario.machineTypeIndex(rule.trigger_type) < 0 || scenario.machineTypeIndex(rule.dependent_type) < 0) {
+            error = "cascade rule: unknown machine type";
+            return false;
+        }
+        if (!(rule.hazard_factor >= 1.0) || isinf(rule.hazard_factor) || rule.duration_days < 1) {
+            error = "cascade rule " + rule.trigger_type + " -> " + rule.dependent_type
+                + ": hazard factor must be at least 1 and the duration at least one day";
+            return false;
+        }
     }
+    return true;
+}
 
-    int randomizedFailureDay(int mttf) {
-        exponential_distribution<double> dist(1.0 / mttf);
-        int day = static_cast<int>(dist(rng));
-        if (day < 1) day = 1; // at least one day until failure
-        return day;
+// ------------------- Runs -------------------
+
+static MetricSummary summarize(const vector<RunResult>& runs, double (*metric)(const RunResult&)) {
+    MetricSummary s;
+    if (runs.empty()) return s;
+    s.min = s.max = metric(runs[0]);
+    double sum = 0.0;
+    for (const RunResult& r : runs) {
+        double v = metric(r);
+        sum += v;
+        s.min = min(s.min, v);
+        s.max = max(s.max, v);
     }
+    s.mean = sum / runs.size();
+    if (runs.size() > 1) {
+        double sq = 0.0;
+        for (const RunResult& r : runs) sq += (metric(r) - s.mean) * (metric(r) - s.mean);
+        s.stdev = sqrt(sq / (runs.size() - 1));
+    }
+    return s;
+}
+
+void summarizeResults(Results& results) {
+    results.machine_uptime = summarize(results.replications, [](const RunResult& r) { return r.machine_uptime; });
+    results.adjuster_utilization = summarize(results.replications, [](const RunResult& r) { return r.adjuster_utilization; });
+    results.repairs_completed = summarize(results.replications, [](const RunResult& r) { return (double)r.repairs_completed; });
+    results.max_queue_length = summarize(results.replications, [](const RunResult& r) { return (double)r.max_queue_length; });
+}
+
+static bool checkOptions(const RunOptions& options, string& error) {
+    error.clear();
+    if (options.days < 1) error = "days must be at least 1";
+    else if (options.replications < 1) error = "replications must be at least 1";
+    else if (options.threads < 0) error = "threads cannot be negative (0 means one per core)";
+    else if (options.recent_events < 0) error = "recent events cannot be negative";
+    else if (options.chunk_days < 0) error = "chunk days cannot be negative (0 means whole replications)";
+    return error.empty();
+}
 
-    bool canAdjusterServiceMachine(int adj_group_index, const string& machine_name) {
-        for (const auto& m : adjuster_groups[adj_group_index].capable_machines) {
-            if (m == machine_name) return true;
+ReplicationRun::ReplicationRun(const Scenario& scenario, const RunOptions& options, unsigned run_seed)
+    : sim(make_unique<FMSSimulator>(scenario)), days(options.days), recent_events(options.recent_events), seed(run_seed) {
+    sim->setEngine(options.engine);
+    sim->setSeed(seed);
+    sim->startSimulation(days);
+}
+
+ReplicationRun::~ReplicationRun() = default;
+
+bool ReplicationRun::advance(int max_days, const atomic<bool>* stop) {
+    const int stop_check_days = 32;
+    int last = max_days > 0 ? min(days, day + max_days) : days;
+    while (day < last) {
+        ++day;
+        if (stop && day % stop_check_days == 0 && *stop) {
+            sim->finishSimulation();
+            day = days;
+            return false;
         }
-        return false;
+        sim->simulateDay(day);
     }
+    return true;
+}
 
-    void runSimulation() {
-        if (machine_types.empty()) {
-            cout << "Error: Add at least one machine type before simulation.\n";
-            return;
+void ReplicationRun::finish(RunResult& result) {
+    sim->finishSimulation();
+    result = sim->result(recent_events);
+    result.seed = seed;
+}
+
+bool runReplication(const Scenario& scenario, const RunOptions& options, unsigned seed, RunResult& result,
+    const atomic<bool>* stop) {
+    ReplicationRun run(scenario, options, seed);
+    if (!run.advance(0, stop)) return false;
+    run.finish(result);
+    return true;
+}
+
+// Every replication of every scenario is a task on a work-stealing pool, or
+// a chain of tasks with chunk_days. Each has its own simulator and seed, and
+// results land at their job index, so the thread count and chunking change
+// the wall time but never the results.
+static bool runReplications(const vector<Scenario>& scenarios, const RunOptions& options,
+    [[maybe_unused]] const char* category, vector<Results>& out, string& error) {
+    unsigned base_seed = options.seed ? options.seed : random_device{}();
+    int total = (int)scenarios.size() * options.replications;
+    vector<Results> results(scenarios.size());
+    for (Results& r : results) r.replications.resize(options.replications);
+    atomic<bool> stopped(false);
+    int done = 0;
+    mutex progress_mutex;
+
+    int threads = options.threads ? options.threads : (int)max(1u, thread::hardware_concurrency());
+    WorkStealingPool pool(min(threads, total));
+    // One chunk; the next goes on this worker's own deque, where it runs
+    // next unless an idle worker steals it
+    function<void(int, shared_ptr<ReplicationRun>)> chunk = [&](int job, shared_ptr<ReplicationRun> run) {
+        if (stopped) return;
+        int point = job / options.replications, r = job % options.replications;
+        if (!run) run = make_shared<ReplicationRun>(scenarios[point], options, base_seed + r);
+        {
+            FMSS_TRACE_SPAN((string(category) == "sweep" ? "point " + to_string(point) + " " : string())
+                + "replication " + to_string(r) + (options.chunk_days ? " from day " + to_string(run->daysDone() + 1) : string()),
+                category);
+            if (!run->advance(options.chunk_days, &stopped)) return;
         }
-        if (adjuster_groups.empty()) {
-            cout << "Error: Add at least one adjuster group before simulation.\n";
+        if (!run->finished()) {
+            pool.submit([&chunk, job, run]() { chunk(job, run); });
             return;
         }
+        run->finish(results[point].replications[r]);
+        if (options.progress) {
+            lock_guard<mutex> lock(progress_mutex);
+            if (!stopped && !options.progress(++done, total)) stopped = true;
+        }
+    };
+    for (int job = 0; job < total; ++job) pool.submit([&chunk, job]() { chunk(job, nullptr); });
+    pool.wait();
 
-        int years = getIntInput("Enter number of years to simulate (>=1): ", 1, 1000);
-        simulation_days = years * 365;
+    if (stopped) {
+        error = "stopped by the progress callback";
+        return false;
+    }
+    for (Results& r : results) summarizeResults(r);
+    out = move(results);
+    return true;
+}
+
+bool runScenario(const Scenario& scenario, const RunOptions& options, Results& results, string& error) {
+    if (!checkOptions(options, error) || !validateScenario(scenario, error)) return false;
+    vector<Results> out;
+    if (!runReplications({ scenario }, options, "replication", out, error)) return false;
+    results = move(out[0]);
+    return true;
+}
+
+bool runSweep(const Scenario& scenario, const Sweep& sweep, const RunOptions& options,
+    vector<Results>& points, string& error) {
+    if (!checkOptions(options, error)) return false;
+    bool group = sweep.parameter == SWEEP_ADJUSTER_COUNT;
+    int targets = group ? (int)scenario.adjuster_groups.size() : (int)scenario.machine_types.size();
+    if (sweep.index < 0 || sweep.index >= targets) {
+        error = string("sweep index is not a valid ") + (group ? "adjuster group" : "machine type");
+        return false;
+    }
+    if (sweep.values.empty()) {
+        error = "sweep has no values";
+        return false;
+    }
 
-        initializeSimulation();
+    vector<Scenario> scenarios(sweep.values.size(), scenario);
+    for (size_t p = 0; p < scenarios.size(); ++p) {
+        int v = sweep.values[p];
+        MachineType* mt = group ? nullptr : &scenarios[p].machine_types[sweep.index];
+        switch (sweep.parameter) {
+        case SWEEP_ADJUSTER_COUNT: scenarios[p].adjuster_groups[sweep.index].count = v; break;
+        case SWEEP_MACHINE_QUANTITY: mt->quantity = v; break;
+        case SWEEP_MTTF: mt->MTTF_days = v; break;
+        case SWEEP_REPAIR_TIME: mt->repair_time = v; break;
+        case SWEEP_SPARES: mt->spares = v; break;
+        }
+        if (!validateScenario(scenarios[p], error)) {
+            error = "sweep value " + to_string(v) + ": " + error;
+            return false;
+        }
+    }
+    return runReplications(scenarios, options, "sweep", points, error);
+}
 
-        cout << "\nStarting simulation for " << years << " year(s) (" << simulation_days << " days)...\n";
+// ------------------- Simulator Class -------------------
 
-        for (int day = 1; day <= simulation_days; ++day) {
-            // Assign adjusters to repair queue machines
-            assignAdjusters();
+FMSSimulator::FMSSimulator() {
+    rng.seed(random_device{}());
+}
 
-            // Update machines for running, failure, repairs
-            updateMachines(day);
+FMSSimulator::FMSSimulator(const Scenario& scenario) : FMSSimulator() {
+    setScenario(scenario);
+}
 
-            // Update adjusters work
-            updateAdjusters(day);
+void FMSSimulator::setScenario(const Scenario& scenario) {
+    machine_types = scenario.machine_types;
+    adjuster_groups = scenario.adjuster_groups;
+    production_lines = scenario.production_lines;
+    zones = scenario.zones;
+    shock_rules = scenario.shock_rules;
+    cascade_rules = scenario.cascade_rules;
+}
 
-            // Track repair queue size and max queue length
-            if ((int)repair_queue.size() > max_queue_length) {
-                max_queue_length = (int)repair_queue.size();
+void FMSSimulator::initializeSimulation() {
+    machines.clear();
+    for (size_t i = 0; i < machine_types.size(); ++i) {
+        MachineType& mt = machine_types[i];
+        // Competing exponential modes: the first failure comes at the total rate
+        mt.effective_mttf = mt.MTTF_days;
+        mt.mode_rate_cum.clear();
+        if (!mt.failure_modes.empty()) {
+            double rate = 0.0;
+            for (const auto& fm : mt.failure_modes) {
+                rate += 1.0 / fm.MTTF_days;
+                mt.mode_rate_cum.push_back(rate);
             }
+            mt.effective_mttf = 1.0 / rate;
+        }
+        mt.weibull_scale = mt.effective_mttf / tgamma(1.0 + 1.0 / mt.weibull_shape);
+        if (!mt.season.empty()) mt.season.prepare();
+    }
+    for (size_t i = 0; i < machine_types.size(); ++i) {
+        vector<MachineInstance> group;
+        for (int q = 0; q < machine_types[i].quantity; ++q) {
+            MachineInstance m(i, q);
+            if (!machine_types[i].machine_zones.empty()) m.zone = machine_types[i].machine_zones[q];
+            // Assign randomized failure day
+            int fail_day = sampleFailureDay(machine_types[i], m, 0);
+            m.failure_day = fail_day;
+            group.push_back(m);
+        }
+        machines.push_back(move(group));
+    }
+    lines.build(production_lines, machine_types);
+
+    adjusters.clear();
+    for (size_t i = 0; i < adjuster_groups.size(); ++i) {
+        vector<AdjusterInstance> group;
+        for (int q = 0; q < adjuster_groups[i].count; ++q) {
+            group.emplace_back(i, q);
+            group.back().zone = adjuster_groups[i].home_zone;
+        }
+        adjusters.push_back(move(group));
+    }
+    free_adjusters = 0;
+    for (const auto& ag : adjuster_groups) free_adjusters += ag.count;
+
+    zones_enabled = zones.size() > 1;
+    if (zones_enabled) {
+        zone_index.build(zones, adjuster_groups);
+        for (auto& group : adjusters) {
+            for (auto& adj : group) zone_index.add(&adj);
+        }
+    }
 
-            timeline.emplace_back(day, "Queue length: " + to_string(repair_queue.size()));
+    shelf_records.assign(machine_types.size(), vector<MachineInstance>());
+    free_shelf.assign(machine_types.size(), vector<MachineInstance*>());
+    spare_swaps.assign(machine_types.size(), 0);
+    for (size_t i = 0; i < machine_types.size(); ++i) {
+        for (int k = 0; k < machine_types[i].spares; ++k) {
+            shelf_records[i].emplace_back(i, machine_types[i].quantity + k);
+            shelf_records[i].back().spare = true;
+            shelf_records[i].back().working = false;
         }
+        for (auto& rec : shelf_records[i]) free_shelf[i].push_back(&rec);
+    }
+    // A machine is in at most one switchover, and only while it is stopped
+    vector<tuple<int, int, int>> switching;
+    size_t switch_capacity = 0;
+    for (const auto& mt : machine_types) {
+        if (mt.spares > 0 && mt.switchover_days > 0) switch_capacity += mt.quantity;
+    }
+    switching.reserve(switch_capacity);
+    switchovers = decltype(switchovers)(greater<tuple<int, int, int>>(), move(switching));
+
+    buildCapabilities();
+
+    on_call_groups.clear();
+    group_active.assign(adjuster_groups.size(), 1);
+    staffing_since.assign(adjuster_groups.size(), -1);
+    staffing_generation.assign(adjuster_groups.size(), 0);
+    active_since.assign(adjuster_groups.size(), 0);
+    active_days.assign(adjuster_groups.size(), 0);
+    call_ins.assign(adjuster_groups.size(), 0);
+    staffing_events.reset(4 * adjuster_groups.size());
+    last_queue_length = 0;
+    capability_all = capability_bits;
+    for (size_t g = 0; g < adjuster_groups.size(); ++g) {
+        if (!adjuster_groups[g].on_call) continue;
+        on_call_groups.push_back((int)g);
+        setGroupActive((int)g, false);
+    }
+    mode_failures.assign(machine_types.size(), vector<long long>());
+    for (size_t i = 0; i < machine_types.size(); ++i) {
+        mode_failures[i].assign(max<size_t>(machine_types[i].failure_modes.size(), 1), 0);
+    }
 
-        displayResults();
+    preemption_enabled = false;
+    for (const auto& mt : machine_types) {
+        if (mt.priority > 0) preemption_enabled = true;
+    }
+    active_jobs.assign(adjuster_groups.size(), JobHeap());
+    for (size_t g = 0; g < adjuster_groups.size(); ++g) active_jobs[g].reset(adjuster_groups[g].count);
+    preemptions = 0;
+    // Every team holds at least one adjuster, so one slot per adjuster is
+    // enough; member lists are sized for the largest crew up front
+    teams.clear();
+    team_count = 0;
+    max_crew = 1;
+    for (const auto& mt : machine_types) max_crew = max(max_crew, mt.max_crew);
+    if (max_crew > 1) {
+        size_t total_adjusters = 0;
+        for (const auto& ag : adjuster_groups) total_adjusters += ag.count;
+        teams.resize(total_adjusters);
+        for (auto& team : teams) team.members.reserve(max_crew);
+        free_buffer.reserve(total_adjusters);
     }
 
+    // Resolve shock and cascade rules to machine type indices
+    auto typeIndex = [&](const string& name) {
+        for (size_t i = 0; i < machine_types.size(); ++i) {
+            if (machine_types[i].name == name) return (int)i;
+        }
+        return -1;
+    };
+    shock_events = decltype(shock_events)();
+    shock_resolved_types.clear();
+    shock_type_start.assign(1, 0);
+    size_t batch_capacity = 0;
+    for (size_t r = 0; r < shock_rules.size(); ++r) {
+        size_t hit = 0;
+        for (const string& name : shock_rules[r].machine_types) {
+            shock_resolved_types.push_back(typeIndex(name));
+            hit += machine_types[shock_resolved_types.back()].quantity;
+        }
+        batch_capacity = max(batch_capacity, hit);
+        shock_type_start.push_back((int)shock_resolved_types.size());
+        shock_events.emplace(nextShockDay(shock_rules[r], 0), (int)r);
+    }
+    shock_batch.clear();
+    shock_batch.reserve(batch_capacity);
+    cascades_by_trigger.assign(machine_types.size(), vector<int>());
+    cascade_dependent.clear();
+    for (size_t r = 0; r < cascade_rules.size(); ++r) {
+        cascades_by_trigger[typeIndex(cascade_rules[r].trigger_type)].push_back((int)r);
+        cascade_dependent.push_back(typeIndex(cascade_rules[r].dependent_type));
+    }
+    shocks = 0;
+    shock_failures = 0;
+    cascade_hazard_raises = 0;
+
+    size_t queue_capacity = 0;
+    for (const auto& group : machines) queue_capacity += group.size();
+    for (const auto& shelf : shelf_records) queue_capacity += shelf.size();
+    repair_queue.reset(queue_capacity);
+    timeline.assign(TIMELINE_CAPACITY, TimelineEvent());
+    timeline_events = 0;
+    queue_records = 0;
+    event_digest = 14695981039346656037ULL;
+
+    failure_calendar.reset(engine == ENGINE_EVENT_CALENDAR ? queue_capacity * 2 : 0);
+    if (engine == ENGINE_EVENT_CALENDAR) {
+        for (auto& group : machines) {
+            for (auto& m : group) scheduleFailure(m);
+        }
+    }
+    max_queue_length = 0;
+    repairs_completed = 0;
+}
 
-    void assignAdjusters() {
-        int qsize = (int)repair_queue.size();
-        for (int i = 0; i < qsize; ++i) {
-            if (repair_queue.empty()) break;
-            MachineInstance* m = repair_queue.front();
-            repair_queue.pop();
+int FMSSimulator::randomizedFailureDay(int mttf) {
+    exponential_distribution<double> dist(1.0 / mttf);
+    int day = static_cast<int>(dist(rng));
+    if (day < 1) day = 1; // at least one day until failure
+    return day;
+}
 
-            bool assigned = false;
+// Running days until the next failure of machine m, which is new or has
+// just been repaired and restarts after start_day. Under an ageing model
+// the Weibull cumulative hazard is inverted in closed form from the
+// machine's virtual age (Kijima) or repair count (hazard multiplier); a
+// seasonal profile then maps that age to calendar days by piecewise
+// inversion. One draw serves the whole run either way.
+int FMSSimulator::sampleFailureDay(const MachineType& mt, const MachineInstance& m, int start_day) {
+    if (mt.ageing_model == AGEING_NONE && mt.season.empty() && mt.failure_modes.empty()) {
+        return randomizedFailureDay(mt.MTTF_days);
+    }
 
-            for (size_t g = 0; g < adjusters.size() && !assigned; ++g) {
-                // Check if adjuster group can work on this machine type
-                if (!canAdjusterServiceMachine((int)g, machine_types[m->group_index].name)) continue;
+    double x = failureAge(mt, m);
+    if (!mt.season.empty()) x = mt.season.stretch(start_day, x);
+    if (x > 1e9) x = 1e9;
+    int day = static_cast<int>(x);
+    if (day < 1) day = 1;
+    return day;
+}
 
-                for (auto& adj : adjusters[g]) {
-                    if (!adj.busy) {
-                        // Assign
-                        adj.busy = true;
-                        adj.days_worked = 0;
-                        adj.required_days = machine_types[m->group_index].repair_time;
-                        adj.current_machine = m;
-                        adj.total_busy_days++;
+// Age (at nominal intensity) the machine runs before its next failure
+double FMSSimulator::failureAge(const MachineType& mt, const MachineInstance& m) {
+    double e = exponential_distribution<double>(1.0)(rng);
+    if (mt.ageing_model == AGEING_NONE) return e * mt.effective_mttf;
 
-                        m->working = false;
-                        m->repair_days = 1; // start counting repair days
+    double beta = mt.weibull_shape;
+    double eta = mt.weibull_scale;
+    if (mt.ageing_model == AGEING_HAZARD_MULTIPLIER) {
+        return eta * pow(e / pow(mt.repair_effect, m.repairs), 1.0 / beta);
+    }
+    double v = m.virtual_age;
+    return eta * pow(pow(v / eta, beta) + e, 1.0 / beta) - v;
+}
 
-                        // Log event
-                        timeline.emplace_back(0, "Assign adjuster "
-                            + to_string(adj.id_in_group + 1) + " of group " + adjuster_groups[g].id
-                            + " to repair machine " + machine_types[m->group_index].name + " #" + to_string(m->id_in_group + 1));
+// Update the machine's ageing state for a run of ran_days that ended in
+// failure on end_day. Under a seasonal profile the run counts at its
+// intensity-weighted length.
+void FMSSimulator::ageMachine(const MachineType& mt, MachineInstance& m, int ran_days, int end_day) {
+    m.repairs++;
+    if (mt.ageing_model == AGEING_NONE || mt.ageing_model == AGEING_HAZARD_MULTIPLIER) return;
+
+    double ran = ran_days;
+    if (!mt.season.empty()) ran = mt.season.cumulative(end_day) - mt.season.cumulative(end_day - ran_days);
+    if (mt.ageing_model == AGEING_KIJIMA_I) {
+        m.virtual_age += mt.repair_effect * ran;
+    }
+    else if (mt.ageing_model == AGEING_KIJIMA_II) {
+        m.virtual_age = mt.repair_effect * (m.virtual_age + ran);
+    }
+}
 
-                        assigned = true;
-                        break;
-                    }
-                }
-            }
-            if (!assigned) {
-                repair_queue.push(m); // enqueue back because no adjuster is free for now
+// Which failure mode a machine failed in: with competing exponential
+// modes the earliest one is mode i with probability rate_i / total rate,
+// independent of when the failure happened
+int FMSSimulator::pickFailureMode(const MachineType& mt) {
+    if (mt.mode_rate_cum.size() < 2) return 0;
+    double u = uniform_real_distribution<double>(0.0, mt.mode_rate_cum.back())(rng);
+    size_t i = upper_bound(mt.mode_rate_cum.begin(), mt.mode_rate_cum.end(), u) - mt.mode_rate_cum.begin();
+    return (int)min(i, mt.mode_rate_cum.size() - 1);
+}
+
+int FMSSimulator::repairTime(const MachineInstance* m) const {
+    const MachineType& mt = machine_types[m->group_index];
+    return mt.failure_modes.empty() ? mt.repair_time : mt.failure_modes[m->failure_mode].repair_time;
+}
+
+void FMSSimulator::buildCapabilities() {
+    cap_words = ((int)adjuster_groups.size() + 63) / 64;
+    cap_offset.assign(machine_types.size() + 1, 0);
+    for (size_t t = 0; t < machine_types.size(); ++t) {
+        cap_offset[t + 1] = cap_offset[t] + (int)max<size_t>(machine_types[t].failure_modes.size(), 1);
+    }
+    capability_bits.assign((size_t)cap_offset.back() * cap_words, 0);
+    for (size_t t = 0; t < machine_types.size(); ++t) {
+        const MachineType& mt = machine_types[t];
+        for (int mode = 0; mode < cap_offset[t + 1] - cap_offset[t]; ++mode) {
+            uint64_t* row = &capability_bits[(size_t)(cap_offset[t] + mode) * cap_words];
+            for (size_t g = 0; g < adjuster_groups.size(); ++g) {
+                if (!canAdjusterServiceMachine((int)g, mt.name)) continue;
+                if (!mt.failure_modes.empty() && !mt.failure_modes[mode].skill.empty()
+                    && !contains(adjuster_groups[g].skills, mt.failure_modes[mode].skill)) continue;
+                row[g >> 6] |= 1ULL << (g & 63);
             }
         }
     }
+}
 
-    void updateMachines(int current_day) {
-        for (size_t g = 0; g < machines.size(); ++g) {
-            for (auto& m : machines[g]) {
-                if (m.working) {
-                    m.running_days++;
-                    if (m.running_days >= m.failure_day) {
-                        // Machine fails now
-                        m.working = false;
-                        timeline.emplace_back(current_day, "Machine " + machine_types[g].name + " #" + to_string(m.id_in_group + 1) + " failed");
-                        m.running_days = 0;
-                        m.repair_days = 0;
-                        // Randomize next failure day for after next repair cycle:
-                        m.failure_day = randomizedFailureDay(machine_types[g].MTTF_days);
+// Bitset row of the adjuster groups able to repair machine m's current failure
+const uint64_t* FMSSimulator::capableGroups(const MachineInstance* m) const {
+    return &capability_bits[(size_t)(cap_offset[m->group_index] + m->failure_mode) * cap_words];
+}
 
-                        repair_queue.push(&m);
-                    }
-                }
-                else {
-                    if (m.repair_days > 0) {
-                        // Under repair, increase repair days count
-                        // actual incremented when adjuster works on it
-                    }
-                    // else waiting for assignment
-                }
-            }
+// Switch a group in or out of dispatch by setting its bit in every
+// capability row, so inactive groups cost nothing during dispatch
+void FMSSimulator::setGroupActive(int g, bool active) {
+    group_active[g] = active;
+    uint64_t bit = 1ULL << (g & 63);
+    for (size_t row = g >> 6; row < capability_bits.size(); row += cap_words) {
+        capability_bits[row] = active ? (capability_bits[row] | (capability_all[row] & bit)) : (capability_bits[row] & ~bit);
+    }
+}
+
+// Hysteresis on queue length for each on-call group. Called when the
+// queue may have changed length.
+void FMSSimulator::queueLengthChanged(int current_day) {
+    int len = (int)repair_queue.size();
+    if (len == last_queue_length) return;
+    last_queue_length = len;
+
+    for (int g : on_call_groups) {
+        const AdjusterGroup& ag = adjuster_groups[g];
+        bool pending = group_active[g] ? len <= ag.release_queue : len > ag.call_in_queue;
+        if (pending && staffing_since[g] < 0) {
+            staffing_since[g] = current_day;
+            int wait = group_active[g] ? ag.release_days : ag.call_in_days;
+            staffing_events.push(make_tuple(current_day + wait, g, staffing_generation[g]),
+                [&](const tuple<int, int, int>& e) { return get<2>(e) != staffing_generation[get<1>(e)]; });
+        }
+        else if (!pending && staffing_since[g] >= 0) {
+            staffing_since[g] = -1;
+            staffing_generation[g]++;
         }
     }
+}
 
-    void updateAdjusters(int current_day) {
-        for (size_t g = 0; g < adjusters.size(); ++g) {
-            for (auto& adj : adjusters[g]) {
-                if (adj.busy) {
-                    adj.days_worked++;
-                    adj.total_busy_days++;
-                    if (adj.days_worked >= adj.required_days) {
-                        // Repair done
-                        timeline.emplace_back(current_day, "Adjuster " + to_string(adj.id_in_group + 1) + " of group "
-                            + adjuster_groups[g].id + " finished repair on machine "
-                            + machine_types[adj.current_machine->group_index].name + " #"
-                            + to_string(adj.current_machine->id_in_group + 1));
-
-                        adj.busy = false;
-                        adj.days_worked = 0;
-                        adj.required_days = 0;
-
-                        // Mark machine as repaired
-                        adj.current_machine->working = true;
-                        adj.current_machine->repair_days = 0;
-                        adj.current_machine->running_days = 0;
-
-                        adj.current_machine = nullptr;
-                    }
-                }
-            }
+void FMSSimulator::processStaffingEvents(int current_day) {
+    FMSS_PHASE(PHASE_STAFFING);
+    while (!staffing_events.empty() && get<0>(staffing_events.top()) <= current_day) {
+        int g = get<1>(staffing_events.top());
+        int generation = get<2>(staffing_events.top());
+        staffing_events.pop();
+        if (generation != staffing_generation[g]) continue;
+
+        staffing_since[g] = -1;
+        staffing_generation[g]++;
+        bool activate = !group_active[g];
+        FMSS_COUNT(COUNT_EVENTS, 1);
+        setGroupActive(g, activate);
+        if (activate) {
+            active_since[g] = current_day;
+            call_ins[g]++;
+        }
+        else {
+            active_days[g] += current_day - active_since[g];
         }
+        logEvent(current_day, activate ? EVENT_CALL_IN : EVENT_RELEASE, g, (int)repair_queue.size());
+
+        // The queue may already be past the opposite threshold
+        last_queue_length = -1;
+        queueLengthChanged(current_day);
     }
+}
 
-    void displayResults() {
-        cout << "\n=== Simulation Results ===\n";
+bool FMSSimulator::canRepair(int g, const MachineInstance* m) const {
+    return (capableGroups(m)[g >> 6] >> (g & 63)) & 1;
+}
 
-        cout << "\nMachine Utilization:\n";
-        cout << left << setw(25) << "Machine Type" << setw(15) << "Quantity" << setw(20) << "Estimated Uptime(%)" << "\n";
-        cout << string(60, '-') << "\n";
+bool FMSSimulator::canAdjusterServiceMachine(int adj_group_index, const string& machine_name) {
+    for (const auto& m : adjuster_groups[adj_group_index].capable_machines) {
+        if (m == machine_name) return true;
+    }
+    return false;
+}
 
-        long long total_machine_days = 0;
-        long long total_machine_working_days = 0;
+// Run a whole simulation without any console interaction
+void FMSSimulator::simulate(int days) {
+    startSimulation(days);
+    for (int day = 1; day <= simulation_days; ++day) {
+        simulateDay(day);
+    }
+    finishSimulation();
+}
 
-        for (size_t g = 0; g < machine_types.size(); ++g) {
-            int q = machine_types[g].quantity;
-            total_machine_days += (long long)q * simulation_days;
+void FMSSimulator::startSimulation(int days) {
+    simulation_days = days;
+    initializeSimulation();
+#ifdef FMSS_PROFILE
+    profile.start();
+    perf_enabled = PerfCounters::requested();
+    if (perf_enabled) perf.start();
+    if (TraceLog::instance().enabled()) {
+        profile.batch_days = max(1, days / 500);
+        profile.run_start_us = profile.batch_start_us = TraceLog::instance().nowUs();
+        profile.batch_start_ticks = profileTicks();
+    }
+#endif
+}
 
-            // Sum total working days over all machines
-            long long working_days = 0;
-            for (const auto& m : machines[g]) {
-                working_days += m.working ? m.running_days : 0;
-            }
-            total_machine_working_days += working_days;
+void FMSSimulator::logEvent(int day, TimelineKind kind, int a, int b, int c, int d, int e) {
+    TimelineEvent& ev = timeline[timeline_events++ % TIMELINE_CAPACITY];
+    ev.day = day;
+    ev.kind = kind;
+    ev.args[0] = a;
+    ev.args[1] = b;
+    ev.args[2] = c;
+    ev.args[3] = d;
+    ev.args[4] = e;
+
+    // FNV-1a over the event's fields
+    for (int v : { day, (int)kind, a, b, c, d, e }) {
+        event_digest = (event_digest ^ (uint32_t)v) * 1099511628211ULL;
+    }
+}
 
-            double uptime = total_machine_days > 0 ? 100.0 * working_days / ((long long)q * simulation_days) : 0.0;
+string FMSSimulator::describeEvent(const TimelineEvent& ev) const {
+    const int* a = ev.args;
+    auto machine = [&](int type, int id) { return machine_types[type].name + " #" + to_string(id + 1); };
+    switch (ev.kind) {
+    case EVENT_QUEUE_LENGTH:
+        return "Queue length: " + to_string(a[0]);
+    case EVENT_FAILURE:
+        return "Machine " + machine(a[0], a[1]) + " failed"
+            + (machine_types[a[0]].failure_modes.empty() ? string() : " (" + machine_types[a[0]].failure_modes[a[2]].name + ")");
+    case EVENT_ASSIGN:
+        return "Assign adjuster " + to_string(a[0] + 1) + " of group " + adjuster_groups[a[1]].id
+            + " to repair machine " + machine(a[2], a[3]);
+    case EVENT_FINISH:
+        return "Adjuster " + to_string(a[0] + 1) + " of group " + adjuster_groups[a[1]].id
+            + " finished repair on machine " + machine(a[2], a[3]);
+    case EVENT_PREEMPT:
+        return "Preempt adjuster " + to_string(a[0] + 1) + " of group " + adjuster_groups[a[1]].id
+            + " from machine " + machine(a[2], a[3]) + " (" + to_string(a[4]) + " repair days left)";
+    case EVENT_TEAM_ASSIGN:
+        return "Assign team of " + to_string(a[0]) + " adjusters to repair machine " + machine(a[1], a[2]);
+    case EVENT_TEAM_GROW:
+        return "Team on machine " + machine(a[0], a[1]) + " grows to " + to_string(a[2])
+            + " adjusters, finishing day " + to_string(a[3]);
+    case EVENT_TEAM_FINISH:
+        return "Team of " + to_string(a[0]) + " finished repair on machine " + machine(a[1], a[2]);
+    case EVENT_SPARE_IN:
+        return "Spare switched in for machine " + machine(a[0], a[1]);
+    case EVENT_SHOCK:
+        return "Shock " + shock_rules[a[0]].name + " failed " + to_string(a[1]) + " machines";
+    case EVENT_CALL_IN:
+    case EVENT_RELEASE:
+        return string(ev.kind == EVENT_CALL_IN ? "Call in" : "Release") + " on-call group " + adjuster_groups[a[0]].id
+            + " (queue length " + to_string(a[1]) + ")";
+    }
+    return string();
+}
 
-            cout << left << setw(25) << machine_types[g].name << setw(15) << q << setw(20) << fixed << setprecision(2) << uptime << "\n";
-        }
+void FMSSimulator::simulateDay(int day) {
+    // Call in or release contractors whose queue condition has held
+    if (!staffing_events.empty() && get<0>(staffing_events.top()) <= day) processStaffingEvents(day);
 
-        double overall_machine_util = total_machine_days > 0 ? 100.0 * total_machine_working_days / total_machine_days : 0;
-        cout << "\nOverall machine utilization: " << fixed << setprecision(2) << overall_machine_util << "%\n";
+    // Assign adjusters to repair queue machines
+    assignAdjusters(day);
 
-        cout << "\nAdjuster Utilization:\n";
-        cout << left << setw(15) << "Adjuster ID" << setw(15) << "Count" << setw(25) << "Estimated Utilization(%)" << "\n";
-        cout << string(60, '-') << "\n";
+    // Update machines for running, failure, repairs
+    updateMachines(day);
 
-        long long total_adjuster_days = 0;
-        long long total_adjuster_busy_days = 0;
+    // Common-cause shocks due today
+    if (!shock_events.empty() && shock_events.top().first <= day) processShocks(day);
 
-        for (size_t g = 0; g < adjuster_groups.size(); ++g) {
-            int c = adjuster_groups[g].count;
-            total_adjuster_days += (long long)c * simulation_days;
+    // Update adjusters work
+    updateAdjusters(day);
 
-            long long busy_days = 0;
-            for (const auto& adj : adjusters[g]) {
-                busy_days += adj.total_busy_days;
-            }
-            total_adjuster_busy_days += busy_days;
+    // Finish team repairs that are due
+    if (team_count > 0) updateTeams(day);
 
-            double util = total_adjuster_days > 0 ? 100.0 * busy_days / ((long long)c * simulation_days) : 0;
+    // Spares finishing their switchover
+    if (!switchovers.empty() && get<0>(switchovers.top()) <= day) processSwitchovers(day);
 
-            cout << left << setw(15) << adjuster_groups[g].id << setw(15) << c << setw(25) << fixed << setprecision(2) << util << "\n";
-        }
-        double overall_adj_util = total_adjuster_days > 0 ? 100.0 * total_adjuster_busy_days / total_adjuster_days : 0;
-        cout << "\nOverall adjuster utilization: " << fixed << setprecision(2) << overall_adj_util << "%\n";
+    recordDay(day);
+#ifdef FMSS_PROFILE
+    if (TraceLog::instance().enabled() && (day % profile.batch_days == 0 || day == simulation_days)) traceDayBatch(day);
+#endif
+}
 
-        cout << "\nMax repair queue length during simulation: " << max_queue_length << "\n";
+#ifdef FMSS_PROFILE
+// One span per batch of days, with a counter event splitting the batch's
+// wall time between the phases in proportion to their ticks
+void FMSSimulator::traceDayBatch(int day) {
+    static const char* phase_keys[] = {
+        "staffing", "dispatch", "machines", "shocks", "adjusters", "teams", "switchovers", "record"
+    };
+    TraceLog& log = TraceLog::instance();
+    double now_us = log.nowUs();
+    uint64_t now_ticks = profileTicks();
+    double us_per_tick = now_ticks > profile.batch_start_ticks ? (now_us - profile.batch_start_us) / (now_ticks - profile.batch_start_ticks) : 0.0;
+
+    vector<pair<string, double>> phase_ms;
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        uint64_t ticks = profile.ticks[p] - profile.batch_phase_ticks[p];
+        if (ticks > 0) phase_ms.emplace_back(phase_keys[p], ticks * us_per_tick / 1000.0);
+        profile.batch_phase_ticks[p] = profile.ticks[p];
+    }
+    string name = day == profile.batch_first_day ? "day " + to_string(day)
+        : "days " + to_string(profile.batch_first_day) + "-" + to_string(day);
+    log.span(name, "simulation",
+        profile.batch_start_us, now_us, { { "queue_length", (double)repair_queue.size() } });
+    log.counter("phase time (ms)", profile.batch_start_us, move(phase_ms));
+
+    profile.batch_first_day = day + 1;
+    profile.batch_start_us = now_us;
+    profile.batch_start_ticks = now_ticks;
+}
+#endif
 
-        // Show timeline summary (last 10 events)
-        cout << "\nRecent Simulation Events (last 10):\n";
-        int start = (int)timeline.size() > 10 ? (int)timeline.size() - 10 : 0;
-        for (size_t i = start; i < timeline.size(); ++i) {
-            cout << "Day " << timeline[i].day << ": " << timeline[i].description << "\n";
+void FMSSimulator::recordDay(int day) {
+    FMSS_PHASE(PHASE_RECORD);
+    // Track repair queue size and max queue length
+    if ((int)repair_queue.size() > max_queue_length) {
+        max_queue_length = (int)repair_queue.size();
+    }
+
+    logEvent(day, EVENT_QUEUE_LENGTH, (int)repair_queue.size());
+    queue_records++;
+}
+
+// Close intervals still open on the last day
+void FMSSimulator::finishSimulation() {
+#ifdef FMSS_PROFILE
+    if (perf_enabled) perf.stop();
+    profile.stop();
+    if (TraceLog::instance().enabled()) {
+        TraceLog::instance().span("simulation", "run", profile.run_start_us, TraceLog::instance().nowUs(),
+            { { "days", (double)simulation_days }, { "events", (double)profile.counters[COUNT_EVENTS] } });
+    }
+#endif
+    lines.finish(simulation_days);
+    if (engine == ENGINE_EVENT_CALENDAR) {
+        for (auto& group : machines) {
+            for (auto& m : group) m.running_days = m.working ? simulation_days - m.run_start : 0;
         }
+    }
+    for (int g : on_call_groups) {
+        if (group_active[g]) active_days[g] += simulation_days + 1 - active_since[g];
+    }
+}
+
+void FMSSimulator::setSeed(unsigned seed) {
+    rng.seed(seed);
+}
 
-        // Detail viewing menu
-        while (true) {
-            cout << "\nView Details:\n1. Machine Types\n2. Adjuster Groups\n3. Exit\n";
-            int choice = getIntInput("Select option: ", 1, 3);
-            if (choice == 3) break;
-            if (choice == 1) showMachineDetails();
-            else if (choice == 2) showAdjusterDetails();
+void FMSSimulator::setEngine(SimulationEngine e) {
+    engine = e;
+}
+
+// Results of the run so far, normally called after finishSimulation()
+RunResult FMSSimulator::result(int recent_events) const {
+    RunResult r;
+    r.seed = 0;
+    r.days = simulation_days;
+
+    long long total_machine_days = 0;
+    long long total_machine_working_days = 0;
+    for (size_t g = 0; g < machine_types.size(); ++g) {
+        const MachineType& mt = machine_types[g];
+        MachineTypeResult t;
+        t.name = mt.name;
+        t.quantity = mt.quantity;
+        total_machine_days += (long long)mt.quantity * simulation_days;
+
+        // Sum total working days over all machines
+        t.working_days = 0;
+        t.working = 0;
+        long long repairs = 0;
+        double age = 0;
+        for (const auto& m : machines[g]) {
+            t.working_days += m.working ? m.running_days : 0;
+            t.working += m.working ? 1 : 0;
+            repairs += m.repairs;
+            age += m.virtual_age;
         }
+        t.broken = (int)machines[g].size() - t.working;
+        total_machine_working_days += t.working_days;
+        t.uptime = simulation_days > 0 ? 100.0 * t.working_days / ((long long)mt.quantity * simulation_days) : 0.0;
+        t.mode_failures = mode_failures[g];
+        t.failures = 0;
+        for (long long f : t.mode_failures) t.failures += f;
+        t.spare_swaps = spare_swaps[g];
+        t.spares_on_shelf = (int)free_shelf[g].size();
+        t.failures_per_machine = (double)repairs / machines[g].size();
+        t.mean_virtual_age = age / machines[g].size();
+        r.machine_types.push_back(t);
     }
+    r.machine_uptime = total_machine_days > 0 ? 100.0 * total_machine_working_days / total_machine_days : 0;
+
+    long long total_adjuster_days = 0;
+    long long total_adjuster_busy_days = 0;
+    r.contractor_cost = 0.0;
+    for (size_t g = 0; g < adjuster_groups.size(); ++g) {
+        const AdjusterGroup& ag = adjuster_groups[g];
+        AdjusterGroupResult a;
+        a.id = ag.id;
+        a.count = ag.count;
+        // On-call groups are measured against the days they were called in
+        a.available_days = ag.on_call ? active_days[g] : simulation_days;
+        total_adjuster_days += (long long)ag.count * a.available_days;
+        a.busy_days = 0;
+        a.busy = 0;
+        for (const auto& adj : adjusters[g]) {
+            a.busy_days += adj.total_busy_days;
+            a.busy += adj.busy ? 1 : 0;
+        }
+        total_adjuster_busy_days += a.busy_days;
+        a.utilization = a.available_days > 0 ? 100.0 * a.busy_days / ((long long)ag.count * a.available_days) : 0;
+        a.call_ins = call_ins[g];
+        a.cost = ag.on_call ? ag.day_rate * ag.count * active_days[g] : 0.0;
+        r.contractor_cost += a.cost;
+        r.adjuster_groups.push_back(a);
+    }
+    r.adjuster_utilization = total_adjuster_days > 0 ? 100.0 * total_adjuster_busy_days / total_adjuster_days : 0;
 
-    void showMachineDetails() {
-        if (machine_types.empty()) {
-            cout << "No machine types.\n";
-            return;
+    r.travel_days = 0;
+    for (const auto& group : adjusters) {
+        for (const auto& adj : group) r.travel_days += adj.travel_days;
+    }
+
+    r.plant_output = 0;
+    r.plant_lost = 0;
+    for (size_t l = 0; l < production_lines.size(); ++l) {
+        const ProductionLine& pl = production_lines[l];
+        LineResult lr;
+        lr.name = pl.name;
+        lr.stages = (int)pl.stages.size();
+        lr.down_days = lines.downDays((int)l);
+        lr.stoppages = lines.stoppages((int)l);
+        lr.output = (long long)pl.throughput * (simulation_days - lr.down_days);
+        lr.lost_output = (long long)pl.throughput * lr.down_days;
+        lr.availability = simulation_days > 0 ? 100.0 * (simulation_days - lr.down_days) / simulation_days : 0.0;
+        r.plant_output += lr.output;
+        r.plant_lost += lr.lost_output;
+        r.lines.push_back(lr);
+    }
+    r.max_lines_down = production_lines.empty() ? 0 : lines.maxLinesDown();
+
+    r.failures = failureCount();
+    r.repairs_completed = repairs_completed;
+    r.max_queue_length = max_queue_length;
+    r.preemptions = preemptions;
+    r.shocks = shocks;
+    r.shock_failures = shock_failures;
+    r.cascade_hazard_raises = cascade_hazard_raises;
+    r.spare_swaps = 0;
+    for (long long n : spare_swaps) r.spare_swaps += n;
+    r.events = timeline_events;
+    r.discrete_events = timeline_events - queue_records;
+    r.event_digest = event_digest;
+
+    long long shown = min<long long>({ (long long)recent_events, timeline_events, (long long)TIMELINE_CAPACITY });
+    for (long long i = timeline_events - shown; i < timeline_events; ++i) {
+        const TimelineEvent& ev = timeline[i % TIMELINE_CAPACITY];
+        r.recent_events.push_back({ ev.day, describeEvent(ev) });
+    }
+
+#ifdef FMSS_PROFILE
+    r.profile = profile;
+    r.perf_enabled = perf_enabled;
+    for (int k = 0; k < PERF_KIND_COUNT; ++k) r.perf[k] = perf.value((PerfCounterKind)k);
+    r.perf_error = perf.openError();
+#endif
+    return r;
+}
+
+long long FMSSimulator::failureCount() const {
+    long long n = 0;
+    for (const auto& type : mode_failures) {
+        for (long long f : type) n += f;
+    }
+    return n;
+}
+
+void FMSSimulator::assignAdjusters(int current_day) {
+    FMSS_PHASE(PHASE_DISPATCH);
+    int qsize = (int)repair_queue.size();
+    for (int i = 0; i < qsize; ++i) {
+        if (repair_queue.empty()) break;
+        MachineInstance* m = repair_queue.front();
+        repair_queue.pop();
+
+        bool assigned = false;
+
+        if (machine_types[m->group_index].usesTeams()) {
+            assigned = startTeamRepair(m, current_day);
         }
-        cout << "Machine Types:\n";
-        for (size_t i = 0; i < machine_types.size(); ++i) {
-            cout << i + 1 << ". " << machine_types[i].name << "\n";
+        else if (zones_enabled) {
+            AdjusterInstance* adj = nearestFreeAdjuster(m);
+            if (adj) {
+                free_adjusters--;
+                startRepair(*adj, m, current_day);
+                assigned = true;
+            }
+            else if (preemption_enabled) {
+                assigned = preemptRepair(m, current_day);
+            }
         }
-        int sel = getIntInput("Select machine type: ", 1, (int)machine_types.size());
-        size_t idx = sel - 1;
+        else {
+            // Only visit the groups able to do this repair
+            const uint64_t* caps = capableGroups(m);
+            for (int w = 0; w < cap_words && !assigned; ++w) {
+                for (uint64_t bits = caps[w]; bits && !assigned; bits &= bits - 1) {
+                    int g = w * 64 + __builtin_ctzll(bits);
+                    for (auto& adj : adjusters[g]) {
+                        if (!adj.busy) {
+                            free_adjusters--;
+                            startRepair(adj, m, current_day);
+                            assigned = true;
+                            break;
+                        }
+                    }
+                }
+            }
+            if (!assigned && preemption_enabled) {
+                assigned = preemptRepair(m, current_day);
+            }
+        }
+        if (!assigned) {
+            FMSS_COUNT(COUNT_REQUEUES, 1);
+            repair_queue.push(m); // enqueue back because no adjuster is free for now
+        }
+    }
 
-        cout << "\nDetails of machine: " << machine_types[idx].name << "\n";
-        cout << "MTTF (days): " << machine_types[idx].MTTF_days << "\n";
-        cout << "Repair time (days): " << machine_types[idx].repair_time << "\n";
-        cout << "Quantity: " << machine_types[idx].quantity << "\n";
+    if (!on_call_groups.empty()) queueLengthChanged(current_day);
 
-        if (machines.size() <= idx) {
-            cout << "No instances available.\n";
-            return;
+    // Adjusters still free can speed up team repairs
+    if (team_count > 0) growTeams(current_day);
+}
+
+AdjusterInstance* FMSSimulator::nearestFreeAdjuster(const MachineInstance* m) {
+    for (int z : zone_index.zonesByDistance(m->zone)) {
+        for (size_t g = 0; g < adjusters.size(); ++g) {
+            AdjusterInstance* adj = zone_index.freeAdjuster(z, (int)g);
+            if (adj && canRepair((int)g, m)) return adj;
         }
+    }
+    return nullptr;
+}
+
+// Whole days travelTo would charge for walking the adjuster to machine m
+int FMSSimulator::travelDays(const AdjusterInstance& adj, const MachineInstance* m) const {
+    if (!zones_enabled) return 0;
+    return (int)(adj.travel_debt + zones[adj.zone].travel_hours[m->zone] / SHIFT_HOURS);
+}
+
+// Walk the adjuster to machine m. Travel is tracked in fractional days and
+// charged as extra whole repair days once it adds up to a full day.
+int FMSSimulator::travelTo(AdjusterInstance& adj, const MachineInstance* m) {
+    if (!zones_enabled) return 0;
+    zone_index.remove(&adj);
+    double days = zones[adj.zone].travel_hours[m->zone] / SHIFT_HOURS;
+    adj.zone = m->zone;
+    adj.travel_days += days;
+    adj.travel_debt += days;
+    int whole = (int)adj.travel_debt;
+    adj.travel_debt -= whole;
+    return whole;
+}
 
-        int working_count = 0, broken_count = 0;
-        for (const auto& m : machines[idx]) {
-            if (m.working)
-                working_count++;
-            else
-                broken_count++;
+// Staff a multi-adjuster repair from any capable groups. The crew is only
+// taken when the whole minimum crew is free, so no adjuster sits reserved
+// while waiting for the rest of a team.
+bool FMSSimulator::startTeamRepair(MachineInstance* m, int current_day) {
+    const MachineType& mt = machine_types[m->group_index];
+    if (free_adjusters < mt.crew_size) return false;
+    crew_buffer.clear();
+    for (size_t g = 0; g < adjusters.size() && (int)crew_buffer.size() < mt.crew_size; ++g) {
+        if (!canRepair((int)g, m)) continue;
+        for (auto& adj : adjusters[g]) {
+            if (!adj.busy) {
+                crew_buffer.push_back(&adj);
+                if ((int)crew_buffer.size() == mt.crew_size) break;
+            }
         }
-        cout << "Currently working: " << working_count << "\n";
-        cout << "Currently broken/repairing: " << broken_count << "\n";
     }
+    if ((int)crew_buffer.size() < mt.crew_size) return false;
+
+    int t = (int)team_count++;
+    RepairTeam& team = teams[t];
+    team.machine = m;
+    team.members.assign(crew_buffer.begin(), crew_buffer.end());
+    team.work_left = m->remaining_repair > 0 ? m->remaining_repair : repairTime(m);
+    // Work starts once the member with the longest walk has arrived
+    int travel = 0;
+    for (AdjusterInstance* adj : team.members) travel = max(travel, travelTo(*adj, m));
+    team.last_update_day = current_day + travel;
+    team.finish_day = teamFinishDay(team.work_left, mt.crewRate(mt.crew_size), team.last_update_day);
+
+    free_adjusters -= (int)team.members.size();
+    for (AdjusterInstance* adj : team.members) {
+        adj->busy = true;
+        adj->days_worked = 0;
+        adj->current_machine = m;
+        adj->team = t;
+        adj->total_busy_days++;
+    }
+    m->working = false;
+    m->repair_days = 1;
+    m->remaining_repair = 0;
 
-    void showAdjusterDetails() {
-        if (adjuster_groups.empty()) {
-            cout << "No adjuster groups.\n";
-            return;
+    logEvent(current_day, EVENT_TEAM_ASSIGN, mt.crew_size, m->group_index, m->id_in_group);
+    return true;
+}
+
+int FMSSimulator::teamFinishDay(double work_left, double rate, int from_day) {
+    int days = (int)ceil(work_left / rate - 1e-9);
+    return from_day + max(days, 1) - 1;
+}
+
+// Let free adjusters join team repairs that can use more hands, and
+// recompute the completion day of every team that grew. Helpers walk to the
+// machine first; the team works at its old size until the last of them has
+// arrived, and no one is sent who would arrive after the repair is done.
+void FMSSimulator::growTeams(int current_day) {
+    // Most days in a busy plant nobody is free; otherwise the free adjusters
+    // are gathered once, in group order, rather than every team scanning
+    // every adjuster
+    if (free_adjusters == 0) return;
+    free_buffer.clear();
+    for (size_t t = 0; t < team_count && free_adjusters > 0; ++t) {
+        RepairTeam& team = teams[t];
+        const MachineType& mt = machine_types[team.machine->group_index];
+        int before = (int)team.members.size();
+        if (before >= mt.max_crew) continue;
+
+        if (free_buffer.empty()) {
+            for (auto& group : adjusters) {
+                for (auto& adj : group) {
+                    if (!adj.busy) free_buffer.push_back(&adj);
+                }
+            }
         }
-        cout << "Adjuster Groups:\n";
-        for (size_t i = 0; i < adjuster_groups.size(); ++i) {
-            cout << i + 1 << ". " << adjuster_groups[i].id << "\n";
+        int travel = 0;
+        for (AdjusterInstance* adj : free_buffer) {
+            if (adj->busy || !canRepair(adj->group_index, team.machine)) continue;
+            if (current_day + travelDays(*adj, team.machine) > team.finish_day) continue;
+            travel = max(travel, travelTo(*adj, team.machine));
+            adj->busy = true;
+            adj->days_worked = 0;
+            adj->current_machine = team.machine;
+            adj->team = (int)t;
+            adj->total_busy_days++;
+            free_adjusters--;
+            team.members.push_back(adj);
+            if ((int)team.members.size() == mt.max_crew) break;
         }
-        int sel = getIntInput("Select adjuster group: ", 1, (int)adjuster_groups.size());
-        size_t idx = sel - 1;
 
-        cout << "\nAdjuster Group: " << adjuster_groups[idx].id << "\n";
-        cout << "Count: " << adjuster_groups[idx].count << "\n";
-        cout << "Services machine types:\n";
-        for (const string& m : adjuster_groups[idx].capable_machines) {
-            cout << "  - " << m << "\n";
+        int after = (int)team.members.size();
+        if (after == before) continue;
+        int arrival = current_day + travel;
+        if (arrival > team.last_update_day) {
+            team.work_left -= mt.crewRate(before) * (arrival - team.last_update_day);
+            team.last_update_day = arrival;
         }
+        team.finish_day = teamFinishDay(team.work_left, mt.crewRate(after), team.last_update_day);
 
-        if (adjusters.size() <= idx) {
-            cout << "No adjuster instances available.\n";
-            return;
+        logEvent(current_day, EVENT_TEAM_GROW, team.machine->group_index, team.machine->id_in_group, after, team.finish_day);
+    }
+}
+
+void FMSSimulator::updateTeams(int current_day) {
+    FMSS_PHASE(PHASE_TEAMS);
+    size_t t = 0;
+    while (t < team_count) {
+        if (teams[t].finish_day > current_day) {
+            ++t;
+            continue;
+        }
+        RepairTeam& team = teams[t];
+        MachineInstance* m = team.machine;
+        logEvent(current_day, EVENT_TEAM_FINISH, (int)team.members.size(), m->group_index, m->id_in_group);
+
+        free_adjusters += (int)team.members.size();
+        for (AdjusterInstance* adj : team.members) {
+            adj->busy = false;
+            adj->team = -1;
+            adj->current_machine = nullptr;
+            if (zones_enabled) zone_index.add(adj);
         }
+        repairs_completed++;
+        FMSS_COUNT(COUNT_EVENTS, 1);
+        returnToService(m, current_day);
+
+        // Swap-remove, keeping the moved team's members pointing at it and
+        // the finished team's member list for the next team
+        if (t + 1 < team_count) {
+            swap(teams[t], teams[team_count - 1]);
+            for (AdjusterInstance* adj : teams[t].members) adj->team = (int)t;
+        }
+        team_count--;
+    }
+}
+
+void FMSSimulator::startRepair(AdjusterInstance& adj, MachineInstance* m, int current_day) {
+    const MachineType& mt = machine_types[m->group_index];
+    adj.busy = true;
+    adj.days_worked = 0;
+    // Resume a preempted repair where it was left off
+    adj.required_days = m->remaining_repair > 0 ? m->remaining_repair : repairTime(m);
+    adj.travel_required = travelTo(adj, m);
+    adj.required_days += adj.travel_required;
+    adj.current_machine = m;
+    adj.total_busy_days++;
+
+    m->working = false;
+    m->repair_days = 1; // start counting repair days
+    m->remaining_repair = 0;
+
+    if (preemption_enabled) active_jobs[adj.group_index].push(mt.priority, adj.id_in_group);
+
+    // Log event
+    logEvent(current_day, EVENT_ASSIGN, adj.id_in_group, adj.group_index, m->group_index, m->id_in_group);
+}
+
+// Pull a capable adjuster off the lowest-priority repair in progress if that
+// repair is less critical than machine m. The displaced machine keeps its
+// remaining repair days, not counting any walk the adjuster had left, and
+// goes back to the queue.
+bool FMSSimulator::preemptRepair(MachineInstance* m, int current_day) {
+    const MachineType& mt = machine_types[m->group_index];
+    int best_group = -1;
+    pair<int, int> best_job;
+    for (size_t g = 0; g < adjusters.size(); ++g) {
+        if (active_jobs[g].empty()) continue;
+        const pair<int, int>& lowest = active_jobs[g].top();
+        if (lowest.first >= mt.priority) continue;
+        if (best_group >= 0 && lowest.first >= best_job.first) continue;
+        if (!canRepair((int)g, m)) continue;
+        best_group = (int)g;
+        best_job = lowest;
+    }
+    if (best_group < 0) return false;
+
+    AdjusterInstance& adj = adjusters[best_group][best_job.second];
+    MachineInstance* displaced = adj.current_machine;
+    displaced->remaining_repair = adj.required_days - max(adj.days_worked, adj.travel_required);
+    active_jobs[best_group].erase(best_job.second);
+    preemptions++;
+
+    logEvent(current_day, EVENT_PREEMPT, adj.id_in_group, best_group, displaced->group_index, displaced->id_in_group,
+        displaced->remaining_repair);
+
+    repair_queue.push(displaced);
+    startRepair(adj, m, current_day);
+    return true;
+}
+
+void FMSSimulator::updateMachines(int current_day) {
+    FMSS_PHASE(PHASE_MACHINES);
+    if (engine == ENGINE_EVENT_CALENDAR) {
+        failScheduledMachines(current_day);
+        return;
+    }
+    for (size_t g = 0; g < machines.size(); ++g) {
+        for (auto& m : machines[g]) {
+            if (m.working) {
+                m.running_days++;
+                if (m.running_days >= m.failure_day) {
+                    // Machine fails now
+                    failMachine(m, current_day);
+                    logEvent(current_day, EVENT_FAILURE, (int)g, m.id_in_group, m.failure_mode);
+                }
+            }
+            else {
+                if (m.repair_days > 0) {
+                    // Under repair, increase repair days count
+                    // actual incremented when adjuster works on it
+                }
+                // else waiting for assignment
+            }
+        }
+    }
+}
+
+void FMSSimulator::failScheduledMachines(int current_day) {
+    updating_machines = true;
+    while (!failure_calendar.empty() && get<0>(failure_calendar.top()) <= current_day) {
+        int day, g, id;
+        tie(day, g, id) = failure_calendar.top();
+        failure_calendar.pop();
+        MachineInstance& m = machines[g][id];
+        if (!m.working || m.run_start + m.failure_day != day) continue;
+        machine_cursor = make_pair(g, id);
+        failMachine(m, current_day);
+        logEvent(current_day, EVENT_FAILURE, g, id, m.failure_mode);
+    }
+    updating_machines = false;
+}
+
+void FMSSimulator::scheduleFailure(const MachineInstance& m) {
+    if (engine == ENGINE_EVENT_CALENDAR && !m.spare) {
+        failure_calendar.push(make_tuple(m.run_start + m.failure_day, m.group_index, m.id_in_group),
+            [&](const tuple<int, int, int>& e) {
+                const MachineInstance& other = machines[get<1>(e)][get<2>(e)];
+                return !other.working || other.run_start + other.failure_day != get<0>(e);
+            });
+    }
+}
+
+// Days machine m has run in its current run, as the day stepper would
+// count them at this point of current_day. While failures are being
+// processed, machines the stepper has not reached yet today are a day
+// behind.
+int FMSSimulator::runningDays(const MachineInstance& m, int current_day) const {
+    if (engine == ENGINE_DAY_STEPPER) return m.running_days;
+    int days = current_day - m.run_start;
+    if (updating_machines && make_pair(m.group_index, m.id_in_group) > machine_cursor) days--;
+    return days;
+}
 
-        int busy_count = 0, idle_count = 0;
-        for (const auto& a : adjusters[idx]) {
-            if (a.busy)
-                busy_count++;
-            else
-                idle_count++;
+void FMSSimulator::failMachine(MachineInstance& m, int current_day) {
+    FMSS_COUNT(COUNT_EVENTS, 1);
+    const MachineType& mt = machine_types[m.group_index];
+    m.failure_mode = pickFailureMode(mt);
+    mode_failures[m.group_index][m.failure_mode]++;
+    ageMachine(mt, m, runningDays(m, current_day), current_day);
+    m.running_days = 0;
+    m.run_start = current_day;
+    m.repair_days = 0;
+
+    vector<MachineInstance*>& shelf = free_shelf[m.group_index];
+    if (shelf.empty()) {
+        m.working = false;
+        lines.machineChanged(m.group_index, m.id_in_group, false, current_day);
+        // Randomize next failure day for after next repair cycle
+        // (seasonal types draw it when they restart, see returnToService)
+        if (mt.season.empty()) m.failure_day = sampleFailureDay(mt, m, current_day);
+        repair_queue.push(&m);
+        if (!on_call_groups.empty()) queueLengthChanged(current_day);
+    }
+    else {
+        // A spare takes over; the failed unit is repaired under a shelf
+        // record and returns to the pool afterwards. The spare carries on
+        // with the machine's ageing state.
+        MachineInstance* unit = shelf.back();
+        shelf.pop_back();
+        unit->failure_mode = m.failure_mode;
+        unit->zone = m.zone;
+        unit->remaining_repair = 0;
+        spare_swaps[m.group_index]++;
+        repair_queue.push(unit);
+        if (!on_call_groups.empty()) queueLengthChanged(current_day);
+
+        if (mt.switchover_days > 0) {
+            m.working = false;
+            lines.machineChanged(m.group_index, m.id_in_group, false, current_day);
+            switchovers.emplace(current_day + mt.switchover_days, m.group_index, m.id_in_group);
+            if (mt.season.empty()) m.failure_day = sampleFailureDay(mt, m, current_day);
+        }
+        else {
+            m.failure_day = sampleFailureDay(mt, m, current_day);
+            scheduleFailure(m);
         }
-        cout << "Currently busy: " << busy_count << "\n";
-        cout << "Currently idle: " << idle_count << "\n";
     }
 
-    void mainMenu() {
-        while (true) {
-            cout << "\n=== Factory Maintenance Optimization Simulator ===\n";
-            cout << "1. Add Machine Type\n";
-            cout << "2. Add Adjuster Group\n";
-            cout << "3. Run Simulation\n";
-            cout << "4. Exit\n";
+    if (!cascades_by_trigger[m.group_index].empty()) applyCascades(m.group_index, current_day);
+}
 
-            int choice = getIntInput("Select option: ", 1, 4);
-            switch (choice) {
-            case 1: addMachineType(); break;
-            case 2: addAdjusterGroup(); break;
-            case 3: runSimulation(); break;
-            case 4: cout << "Goodbye!\n"; return;
+void FMSSimulator::processSwitchovers(int current_day) {
+    FMSS_PHASE(PHASE_SWITCHOVERS);
+    while (!switchovers.empty() && get<0>(switchovers.top()) <= current_day) {
+        FMSS_COUNT(COUNT_EVENTS, 1);
+        MachineInstance* m = &machines[get<1>(switchovers.top())][get<2>(switchovers.top())];
+        switchovers.pop();
+        returnToService(m, current_day);
+        logEvent(current_day, EVENT_SPARE_IN, m->group_index, m->id_in_group);
+    }
+}
+
+int FMSSimulator::nextShockDay(const ShockRule& rule, int after_day) {
+    exponential_distribution<double> dist(1.0 / rule.mean_interval_days);
+    return after_day + max(1, (int)dist(rng));
+}
+
+// Index `skip` places on from `from` under geometric skipping, or `n` once
+// that is past the end. A tiny probability gives skips far beyond any
+// group, so they are drawn as long long and never added on overflow.
+static size_t skipAhead(size_t from, long long skip, size_t n) {
+    return (unsigned long long)skip >= n - from ? n : from + (size_t)skip;
+}
+
+// Fire every shock due today. The machines hit are picked by geometric
+// skipping, so a shock costs O(machines hit) draws rather than one per
+// machine, and the whole batch is failed and enqueued together.
+void FMSSimulator::processShocks(int current_day) {
+    FMSS_PHASE(PHASE_SHOCKS);
+    while (!shock_events.empty() && shock_events.top().first <= current_day) {
+        FMSS_COUNT(COUNT_EVENTS, 1);
+        int r = shock_events.top().second;
+        shock_events.pop();
+        const ShockRule& rule = shock_rules[r];
+
+        shock_batch.clear();
+        geometric_distribution<long long> skip(rule.fail_probability);
+        for (int t = shock_type_start[r]; t < shock_type_start[r + 1]; ++t) {
+            vector<MachineInstance>& group = machines[shock_resolved_types[t]];
+            size_t n = group.size();
+            for (size_t i = skipAhead(0, skip(rng), n); i < n; i = skipAhead(i + 1, skip(rng), n)) {
+                if (group[i].working) shock_batch.push_back(&group[i]);
             }
         }
+
+        for (MachineInstance* m : shock_batch) failMachine(*m, current_day);
+        shocks++;
+        shock_failures += shock_batch.size();
+        logEvent(current_day, EVENT_SHOCK, r, (int)shock_batch.size());
+
+        shock_events.emplace(nextShockDay(rule, current_day), r);
     }
-};
+}
 
+// A failure of type `trigger` adds (factor - 1) x the nominal hazard to
+// working machines of each dependent type for the rule's duration. The
+// extra hazard is a competing risk: a machine is hit within the window
+// with probability p, chosen by geometric skipping, and its failure is
+// brought forward to a truncated-exponential time inside the window if
+// that is earlier than the failure it already has scheduled.
+void FMSSimulator::applyCascades(int trigger, int current_day) {
+    for (int r : cascades_by_trigger[trigger]) {
+        const CascadeRule& rule = cascade_rules[r];
+        int dep = cascade_dependent[r];
+
+        double extra_rate = (rule.hazard_factor - 1.0) / machine_types[dep].effective_mttf;
+        double p = 1.0 - exp(-extra_rate * rule.duration_days);
+        if (p <= 0.0) continue;
+
+        geometric_distribution<long long> skip(p);
+        uniform_real_distribution<double> unit(0.0, 1.0);
+        vector<MachineInstance>& group = machines[dep];
+        size_t n = group.size();
+        for (size_t i = skipAhead(0, skip(rng), n); i < n; i = skipAhead(i + 1, skip(rng), n)) {
+            MachineInstance& m = group[i];
+            if (!m.working) continue;
+            double t = -log(1.0 - unit(rng) * p) / extra_rate;
+            int fail_day = runningDays(m, current_day) + max(1, (int)t);
+            if (fail_day < m.failure_day) {
+                m.failure_day = fail_day;
+                cascade_hazard_raises++;
+                scheduleFailure(m);
+            }
+        }
+    }
+}
+
+void FMSSimulator::updateAdjusters(int current_day) {
+    FMSS_PHASE(PHASE_ADJUSTERS);
+    for (size_t g = 0; g < adjusters.size(); ++g) {
+        for (auto& adj : adjusters[g]) {
+            if (adj.busy) {
+                if (adj.team >= 0) {
+                    // Team progress is tracked per team in updateTeams
+                    adj.total_busy_days++;
+                    continue;
+                }
+                adj.days_worked++;
+                adj.total_busy_days++;
+                if (adj.days_worked >= adj.required_days) {
+                    // Repair done
+                    logEvent(current_day, EVENT_FINISH, adj.id_in_group, (int)g, adj.current_machine->group_index,
+                        adj.current_machine->id_in_group);
+
+                    if (preemption_enabled) {
+                        active_jobs[g].erase(adj.id_in_group);
+                    }
 
-// ------------------- Main -------------------
+                    adj.busy = false;
+                    free_adjusters++;
+                    adj.days_worked = 0;
+                    adj.required_days = 0;
+                    adj.travel_required = 0;
 
-int main() {
-    FMSSimulator sim;
-    sim.mainMenu();
-    return 0;
+                    // Mark machine as repaired
+                    repairs_completed++;
+                    FMSS_COUNT(COUNT_EVENTS, 1);
+                    returnToService(adj.current_machine, current_day);
+
+                    adj.current_machine = nullptr;
+                    if (zones_enabled) zone_index.add(&adj);
+                }
+            }
+        }
+    }
 }
-    
\ No newline at end of file
+
+// Machine m is repaired and starts running again after current_day
+void FMSSimulator::returnToService(MachineInstance* m, int current_day) {
+    if (m->spare) {
+        // Repaired spare goes back on the shelf
+        m->repair_days = 0;
+        free_shelf[m->group_index].push_back(m);
+        return;
+    }
+    m->working = true;
+    m->repair_days = 0;
+    m->running_days = 0;
+    m->run_start = current_day;
+    lines.machineChanged(m->group_index, m->id_in_group, true, current_day);
+
+    // A seasonal failure time depends on the calendar day the run starts
+    const MachineType& mt = machine_types[m->group_index];
+    if (!mt.season.empty()) m->failure_day = sampleFailureDay(mt, *m, current_day);
+    scheduleFailure(*m);
+}
+
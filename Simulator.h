@@ -0,0 +1,1320 @@
+// Factory Maintenance Optimization Simulator: machine, adjuster and line
+// model and the FMSSimulator engine. Built as the fmss_core library; the
+// console program (Main.cpp, Menu.cpp), benchmarks and tests link against it.
+
+#pragma once
+
+#include <istream>
+#include <string>
+#include <vector>
+#include <queue>
+#include <map>
+#include <set>
+#include <tuple>
+#include <limits>
+#include <stdexcept>
+#include <random>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+// ----------- Structs and Classes ------------
+
+// How repairs leave a machine's failure behaviour
+enum AgeingModel {
+    AGEING_NONE,                // as good as new after every repair
+    AGEING_KIJIMA_I,            // repair removes part of the last run's age
+    AGEING_KIJIMA_II,           // repair removes part of the accumulated age
+    AGEING_HAZARD_MULTIPLIER    // hazard multiplied by a constant after each repair
+};
+
+// How the simulator finds machine failures
+enum SimulationEngine {
+    ENGINE_DAY_STEPPER,     // reference: every working machine is advanced every day
+    ENGINE_EVENT_CALENDAR   // failures come off a calendar ordered by (day, type, machine)
+};
+
+// Piecewise-constant failure intensity over the calendar (e.g. summer heat,
+// production ramp-ups). A machine's failure clock runs at the factor of the
+// current segment, so a failure time drawn at nominal intensity is mapped to
+// calendar days by inverting the cumulative intensity.
+struct IntensityProfile {
+    std::vector<int> days;      // length of each segment
+    std::vector<double> factor; // intensity multiplier in each segment
+    bool repeats = true;        // restart after the last segment, else the last factor holds
+
+    // Cumulative tables, filled by prepare()
+    std::vector<double> seg_start;
+    std::vector<double> seg_cum;
+    double period = 0.0;
+    double period_total = 0.0;
+
+    bool empty() const { return days.empty(); }
+
+    void prepare() {
+        seg_start.assign(days.size() + 1, 0.0);
+        seg_cum.assign(days.size() + 1, 0.0);
+        for (size_t i = 0; i < days.size(); ++i) {
+            seg_start[i + 1] = seg_start[i] + days[i];
+            seg_cum[i + 1] = seg_cum[i] + days[i] * factor[i];
+        }
+        period = seg_start.back();
+        period_total = seg_cum.back();
+    }
+
+    // Intensity-weighted days from calendar day 0 to t
+    double cumulative(double t) const {
+        double base = 0.0;
+        if (t >= period) {
+            if (!repeats) return period_total + (t - period) * factor.back();
+            double k = std::floor(t / period);
+            base = k * period_total;
+            t = std::max(t - k * period, 0.0); // rounding can leave a tiny negative remainder
+        }
+        size_t i = std::upper_bound(seg_start.begin(), seg_start.end(), t) - seg_start.begin() - 1;
+        if (i >= days.size()) i = days.size() - 1;
+        return base + seg_cum[i] + (t - seg_start[i]) * factor[i];
+    }
+
+    // Calendar day at which the cumulative intensity reaches c
+    double inverse(double c) const {
+        double base = 0.0;
+        if (c >= period_total) {
+            if (!repeats) {
+                if (factor.back() <= 0.0) return std::numeric_limits<double>::infinity();
+                return period + (c - period_total) / factor.back();
+            }
+            double k = std::floor(c / period_total);
+            base = k * period;
+            c = std::max(c - k * period_total, 0.0);
+        }
+        size_t i = std::upper_bound(seg_cum.begin(), seg_cum.end(), c) - seg_cum.begin() - 1;
+        while (i + 1 < days.size() && factor[i] <= 0.0) ++i;
+        if (i >= days.size()) i = days.size() - 1;
+        return base + seg_start[i] + (c - seg_cum[i]) / factor[i];
+    }
+
+    // Calendar days from `start` until `age` intensity-weighted days have passed
+    double stretch(double start, double age) const {
+        return inverse(cumulative(start) + age) - start;
+    }
+};
+
+// One of several competing ways a machine type can fail
+struct FailureMode {
+    std::string name;
+    int MTTF_days;      // mean time to failure in this mode alone
+    int repair_time;    // repair days for this mode
+    std::string skill;  // skill an adjuster group needs for the repair, empty = any capable group
+
+    FailureMode(const std::string& n, int m, int r, const std::string& s) : name(n), MTTF_days(m), repair_time(r), skill(s) {}
+};
+
+// Machine type info
+struct MachineType {
+    std::string name;
+    int MTTF_days;      // mean time to failure in days
+    int repair_time;    // repair days
+    int quantity;       // number of machines
+    int priority = 0;   // criticality; higher-priority failures may preempt repairs
+    int crew_size = 1;  // adjusters needed to start a repair
+    int max_crew = 1;   // adjusters that can work on one repair at once
+    std::vector<double> crew_speedup; // work rate with crew_size+1.. max_crew adjusters (crew_size = 1.0)
+    std::vector<int> machine_zones; // zone of each machine, empty = all in the first zone
+    AgeingModel ageing_model = AGEING_NONE;
+    double weibull_shape = 1.0;  // life distribution shape; > 1 means wear-out
+    double repair_effect = 0.0;  // Kijima: share of age kept after repair; multiplier model: hazard factor per repair
+    double weibull_scale = 0.0;  // derived from MTTF_days and the shape when the simulation starts
+    IntensityProfile season;     // calendar profile of the failure rate, empty = constant
+    std::vector<FailureMode> failure_modes; // competing failure modes, empty = MTTF_days/repair_time only
+    double effective_mttf = 0.0;        // mean time to the first of all modes, set when the simulation starts
+    std::vector<double> mode_rate_cum;  // cumulative failure rates of the modes, for picking one
+    int spares = 0;             // cold-standby units kept on the shelf
+    int switchover_days = 0;    // days to put a spare in place of a failed machine
+    MachineType() = default;
+    MachineType(const std::string& n, int m, int r, int q) : name(n), MTTF_days(m), repair_time(r), quantity(q) {}
+
+    bool usesTeams() const { return max_crew > 1; }
+
+    // Repair progress per day with n adjusters, relative to the minimum crew
+    double crewRate(int n) const {
+        if (n <= crew_size || crew_speedup.empty()) return 1.0;
+        size_t i = std::min((size_t)(n - crew_size), crew_speedup.size());
+        return crew_speedup[i - 1];
+    }
+};
+
+// Machine instance for simulation
+struct MachineInstance {
+    int group_index;
+    int id_in_group;
+    bool working;            // true = working, false = broken/repair
+    int running_days;        // days machine worked since last repair/failure
+    int repair_days;         // days spent repairing so far
+    int failure_day;         // day count until next failure (randomized)
+    int remaining_repair;    // repair days left on a preempted repair, 0 if none
+    int zone;                // plant zone the machine stands in
+    int repairs;             // failures so far
+    double virtual_age;      // effective age in days under an ageing model
+    int failure_mode;        // mode of the current/last failure, 0 for types without modes
+    bool spare;              // shelf record for a unit swapped out and repaired as a spare
+    int run_start;           // day the current run started; the event engine derives running_days from it
+
+    MachineInstance(int group, int id)
+        : group_index(group), id_in_group(id), working(true),
+          running_days(0), repair_days(0), failure_day(-1), remaining_repair(0), zone(0),
+          repairs(0), virtual_age(0.0), failure_mode(0), spare(false), run_start(0) {}
+};
+
+// Adjuster group info
+struct AdjusterGroup {
+    std::string id;
+    int count;
+    std::vector<std::string> capable_machines; // machine types the group can service
+    int home_zone = 0;               // zone the group's adjusters start from
+    std::vector<std::string> skills; // skills required by some failure modes
+
+    // On-call contractors, called in when the repair queue stays long
+    bool on_call = false;
+    int call_in_queue = 0;      // called in when the queue is longer than this...
+    int call_in_days = 0;       // ...for this many days
+    int release_queue = 0;      // released when the queue is at most this long...
+    int release_days = 0;       // ...for this many days
+    double day_rate = 0.0;      // cost per adjuster per day called in
+
+    AdjusterGroup() = default;
+    AdjusterGroup(const std::string& i, int c, const std::vector<std::string>& caps) : id(i), count(c), capable_machines(caps) {}
+};
+
+// Adjuster instance for simulation
+struct AdjusterInstance {
+    int group_index;
+    int id_in_group;
+    bool busy;
+    int days_worked;            // days spent working on current repair
+    int required_days;          // total repair days required for current job
+    int travel_required;        // of those, the leading days spent walking to the machine
+    MachineInstance* current_machine;  // pointer to machine being repaired
+    int total_busy_days;
+    int team;                   // repair team the adjuster works in, -1 if working alone
+    int zone;                   // zone the adjuster is currently in
+    int bucket_pos;             // position in its free-adjuster zone bucket, -1 if not in one
+    double travel_debt;         // travel days not yet charged as a whole day of work
+    double travel_days;         // total days spent walking between zones
+
+    AdjusterInstance(int group_idx, int id)
+        : group_index(group_idx), id_in_group(id), busy(false),
+          days_worked(0), required_days(0), travel_required(0), current_machine(nullptr), total_busy_days(0), team(-1),
+          zone(0), bucket_pos(-1), travel_debt(0.0), travel_days(0.0) {}
+};
+
+// Repair carried out by several adjusters together
+struct RepairTeam {
+    MachineInstance* machine;
+    std::vector<AdjusterInstance*> members;
+    double work_left;       // repair days left at the minimum-crew rate
+    int last_update_day;    // first day worked at the current team size
+    int finish_day;         // last day of work at the current team size
+};
+
+// Kinds of timeline events
+enum TimelineKind {
+    EVENT_QUEUE_LENGTH,     // queue length
+    EVENT_FAILURE,          // machine type, machine, failure mode
+    EVENT_ASSIGN,           // adjuster, group, machine type, machine
+    EVENT_FINISH,           // adjuster, group, machine type, machine
+    EVENT_PREEMPT,          // adjuster, group, machine type, machine, repair days left
+    EVENT_TEAM_ASSIGN,      // crew size, machine type, machine
+    EVENT_TEAM_GROW,        // machine type, machine, crew size, finish day
+    EVENT_TEAM_FINISH,      // crew size, machine type, machine
+    EVENT_SPARE_IN,         // machine type, machine
+    EVENT_SHOCK,            // shock rule, machines failed
+    EVENT_CALL_IN,          // group, queue length
+    EVENT_RELEASE           // group, queue length
+};
+
+// Event for timeline logging. Held as numbers so that logging neither
+// formats nor allocates; the text is built when the timeline is shown.
+struct TimelineEvent {
+    int day;
+    TimelineKind kind;
+    int args[5];
+};
+
+// FIFO on a power-of-two ring. Reserved for the whole fleet at the start of
+// a run, so queueing does not allocate while simulating.
+template <typename T>
+class RingQueue {
+private:
+    std::vector<T> slots;
+    size_t head = 0;
+    size_t count = 0;
+
+public:
+    void reset(size_t capacity) {
+        size_t n = 1;
+        while (n < capacity) n <<= 1;
+        slots.assign(n, T());
+        head = 0;
+        count = 0;
+    }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    T& front() { return slots[head]; }
+
+    void pop() {
+        head = (head + 1) & (slots.size() - 1);
+        count--;
+    }
+
+    void push(const T& value) {
+        if (count == slots.size()) grow();
+        slots[(head + count) & (slots.size() - 1)] = value;
+        count++;
+    }
+
+private:
+    void grow() {
+        std::vector<T> bigger(std::max<size_t>(slots.size() * 2, 16));
+        for (size_t i = 0; i < count; ++i) bigger[i] = slots[(head + i) & (slots.size() - 1)];
+        slots.swap(bigger);
+        head = 0;
+    }
+};
+
+// Plant zone (hall) with walking times to the other zones
+struct Zone {
+    std::string name;
+    std::vector<double> travel_hours; // walking time to each zone, by zone index
+
+    Zone(const std::string& n) : name(n) {}
+};
+
+// Common-cause shock (e.g. a power dip) that fails a random subset of machines
+struct ShockRule {
+    std::string name;
+    double mean_interval_days;      // mean days between shocks
+    double fail_probability;        // chance that each working machine of an affected type fails
+    std::vector<std::string> machine_types; // affected machine types
+
+    ShockRule(const std::string& n, double i, double p, const std::vector<std::string>& types)
+        : name(n), mean_interval_days(i), fail_probability(p), machine_types(types) {}
+};
+
+// Cascade: a failure of one machine type raises the hazard of another for a while
+struct CascadeRule {
+    std::string trigger_type;
+    std::string dependent_type;
+    double hazard_factor;   // hazard multiplier on working dependent machines
+    int duration_days;      // days the raised hazard lasts
+
+    CascadeRule(const std::string& t, const std::string& d, double f, int days)
+        : trigger_type(t), dependent_type(d), hazard_factor(f), duration_days(days) {}
+};
+
+// Production line stage: a block of machines of one type, k of which must run
+struct LineStage {
+    std::string machine_type;
+    int first_machine;  // 1-based number of the first machine in the stage
+    int count;          // machines in the stage (parallel redundancy)
+    int required;       // machines needed for the stage to run (k-of-n)
+
+    LineStage(const std::string& mt, int f, int c, int r) : machine_type(mt), first_machine(f), count(c), required(r) {}
+};
+
+// Production line: stages in series
+struct ProductionLine {
+    std::string name;
+    int throughput;     // output units per day while the line runs
+    std::vector<LineStage> stages;
+
+    ProductionLine() = default;
+    ProductionLine(const std::string& n, int t, const std::vector<LineStage>& s) : name(n), throughput(t), stages(s) {}
+};
+
+
+// Repairs in progress within one adjuster group, keyed (priority, adjuster)
+// with the smallest key on top: an indexed binary heap over slots reserved
+// for the group's adjusters, so starting and finishing jobs never allocate.
+class JobHeap {
+private:
+    std::vector<std::pair<int, int>> heap;
+    std::vector<int> position; // heap index of each adjuster's job, -1 if none
+
+public:
+    void reset(int adjusters) {
+        heap.clear();
+        heap.reserve(adjusters);
+        position.assign(adjusters, -1);
+    }
+
+    bool empty() const { return heap.empty(); }
+    const std::pair<int, int>& top() const { return heap.front(); }
+
+    void push(int priority, int adj) {
+        heap.emplace_back(priority, adj);
+        position[adj] = (int)heap.size() - 1;
+        siftUp((int)heap.size() - 1);
+    }
+
+    void erase(int adj) {
+        int i = position[adj];
+        if (i < 0) return;
+        position[adj] = -1;
+        int last = (int)heap.size() - 1;
+        if (i != last) {
+            heap[i] = heap[last];
+            position[heap[i].second] = i;
+        }
+        heap.pop_back();
+        if (i < (int)heap.size()) {
+            if (i > 0 && heap[i] < heap[(i - 1) / 2]) siftUp(i);
+            else siftDown(i);
+        }
+    }
+
+private:
+    void place(int i, const std::pair<int, int>& job) {
+        heap[i] = job;
+        position[job.second] = i;
+    }
+
+    void siftUp(int i) {
+        std::pair<int, int> job = heap[i];
+        while (i > 0 && job < heap[(i - 1) / 2]) {
+            place(i, heap[(i - 1) / 2]);
+            i = (i - 1) / 2;
+        }
+        place(i, job);
+    }
+
+    void siftDown(int i) {
+        std::pair<int, int> job = heap[i];
+        int n = (int)heap.size();
+        while (true) {
+            int child = 2 * i + 1;
+            if (child >= n) break;
+            if (child + 1 < n && heap[child + 1] < heap[child]) child++;
+            if (!(heap[child] < job)) break;
+            place(i, heap[child]);
+            i = child;
+        }
+        place(i, job);
+    }
+};
+
+// Min-heap of scheduled events in a buffer reserved at the start of a run.
+// Entries may go stale and are skipped when popped; when the buffer is full,
+// a push first drops the stale ones instead of growing it.
+template <typename T>
+class EventHeap {
+private:
+    std::vector<T> heap;
+
+public:
+    void reset(size_t capacity) {
+        heap.clear();
+        heap.reserve(capacity);
+    }
+
+    bool empty() const { return heap.empty(); }
+    const T& top() const { return heap.front(); }
+
+    void pop() {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<T>());
+        heap.pop_back();
+    }
+
+    template <typename Stale>
+    void push(const T& event, Stale stale) {
+        if (heap.size() == heap.capacity()) {
+            heap.erase(std::remove_if(heap.begin(), heap.end(), stale), heap.end());
+            std::make_heap(heap.begin(), heap.end(), std::greater<T>());
+        }
+        heap.push_back(event);
+        std::push_heap(heap.begin(), heap.end(), std::greater<T>());
+    }
+};
+
+
+// ------------------- Helpers -------------------
+
+bool contains(const std::vector<std::string>& vec, const std::string& val);
+
+// ------------------- Production Line Network -------------------
+
+// Node of the line dependency graph. Machines are the leaves; a node is up
+// while at least `required` of its children are up.
+struct LineNode {
+    int parent;         // parent node, -1 for a line root
+    int line;           // line this node belongs to
+    int required;       // children that must be up
+    int up_children;
+    bool up;
+
+    LineNode(int p, int l, int r, int c) : parent(p), line(l), required(r), up_children(c), up(c >= r) {}
+};
+
+// Line state kept incrementally: a machine failure or repair walks up from the
+// machine's stage nodes only as far as some node actually changes state, so the
+// cost per event does not depend on how many lines the plant has.
+class LineNetwork {
+private:
+    std::vector<LineNode> nodes;
+    std::vector<int> group_offset;  // first machine index of each machine type
+    std::vector<int> feed_start;    // per machine: range of feed_nodes it drives
+    std::vector<int> feed_nodes;    // stage nodes fed by each machine
+
+    std::vector<int> line_root;
+    std::vector<int> line_down_since;
+    std::vector<long long> line_down_days;
+    std::vector<int> line_stoppages;
+    int lines_down = 0;
+    int max_lines_down = 0;
+
+public:
+    void build(const std::vector<ProductionLine>& lines, const std::vector<MachineType>& types) {
+        nodes.clear();
+        group_offset.assign(types.size() + 1, 0);
+        for (size_t g = 0; g < types.size(); ++g) {
+            group_offset[g + 1] = group_offset[g] + types[g].quantity;
+        }
+
+        // Collect (machine, stage node) edges, then pack them per machine
+        std::vector<std::pair<int, int>> edges;
+        line_root.clear();
+        for (size_t l = 0; l < lines.size(); ++l) {
+            int root = (int)nodes.size();
+            line_root.push_back(root);
+            int stage_count = (int)lines[l].stages.size();
+            nodes.emplace_back(-1, (int)l, stage_count, stage_count);
+
+            for (const auto& st : lines[l].stages) {
+                int g = 0;
+                while (g < (int)types.size() && types[g].name != st.machine_type) ++g;
+                int node = (int)nodes.size();
+                nodes.emplace_back(root, (int)l, st.required, st.count);
+                for (int i = 0; i < st.count; ++i) {
+                    edges.emplace_back(group_offset[g] + st.first_machine - 1 + i, node);
+                }
+            }
+        }
+
+        int machine_count = group_offset.back();
+        feed_start.assign(machine_count + 1, 0);
+        for (const auto& e : edges) feed_start[e.first + 1]++;
+        for (int i = 0; i < machine_count; ++i) feed_start[i + 1] += feed_start[i];
+        feed_nodes.assign(edges.size(), 0);
+        std::vector<int> fill(feed_start.begin(), feed_start.end() - 1);
+        for (const auto& e : edges) feed_nodes[fill[e.first]++] = e.second;
+
+        line_down_since.assign(lines.size(), 0);
+        line_down_days.assign(lines.size(), 0);
+        line_stoppages.assign(lines.size(), 0);
+        lines_down = 0;
+        max_lines_down = 0;
+    }
+
+    // Called whenever a machine starts or stops working
+    void machineChanged(int group, int id, bool up, int day) {
+        if (nodes.empty()) return;
+        int idx = group_offset[group] + id;
+        for (int f = feed_start[idx]; f < feed_start[idx + 1]; ++f) {
+            propagate(feed_nodes[f], up ? 1 : -1, day);
+        }
+    }
+
+    // Close downtime intervals still open at the end of the run
+    void finish(int end_day) {
+        for (size_t l = 0; l < line_root.size(); ++l) {
+            if (!nodes[line_root[l]].up) line_down_days[l] += end_day - line_down_since[l];
+        }
+    }
+
+    bool lineUp(int line) const { return nodes[line_root[line]].up; }
+    long long downDays(int line) const { return line_down_days[line]; }
+    int stoppages(int line) const { return line_stoppages[line]; }
+    int maxLinesDown() const { return max_lines_down; }
+
+private:
+    void propagate(int node, int delta, int day) {
+        while (true) {
+            LineNode& n = nodes[node];
+            n.up_children += delta;
+            bool up = n.up_children >= n.required;
+            if (up == n.up) return;
+            n.up = up;
+            if (n.parent < 0) {
+                lineChanged(n.line, up, day);
+                return;
+            }
+            delta = up ? 1 : -1;
+            node = n.parent;
+        }
+    }
+
+    void lineChanged(int line, bool up, int day) {
+        if (up) {
+            line_down_days[line] += day - line_down_since[line];
+            lines_down--;
+        }
+        else {
+            line_down_since[line] = day;
+            line_stoppages[line]++;
+            if (++lines_down > max_lines_down) max_lines_down = lines_down;
+        }
+    }
+};
+
+// ------------------- Zone Dispatch Index -------------------
+
+// Free adjusters bucketed by (zone, group). The nearest free adjuster for a
+// machine is found by walking zones in order of travel time from the machine's
+// zone and taking the first non-empty bucket of a capable group, so dispatch
+// cost grows with the number of zones rather than the number of adjusters.
+class ZoneIndex {
+private:
+    int group_count = 0;
+    std::vector<std::vector<AdjusterInstance*>> buckets; // [zone * group_count + group]
+    std::vector<std::vector<int>> zone_order;   // zones by travel time from each zone
+
+public:
+    // Buckets are reserved for their whole group, so moving adjusters
+    // between zones never allocates
+    void build(const std::vector<Zone>& zones, const std::vector<AdjusterGroup>& groups) {
+        group_count = (int)groups.size();
+        buckets.assign(zones.size() * groups.size(), std::vector<AdjusterInstance*>());
+        for (size_t b = 0; b < buckets.size(); ++b) buckets[b].reserve(groups[b % groups.size()].count);
+        zone_order.assign(zones.size(), std::vector<int>());
+        for (size_t z = 0; z < zones.size(); ++z) {
+            std::vector<int>& order = zone_order[z];
+            for (size_t o = 0; o < zones.size(); ++o) order.push_back((int)o);
+            const std::vector<double>& hours = zones[z].travel_hours;
+            std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return hours[a] < hours[b]; });
+        }
+    }
+
+    void add(AdjusterInstance* adj) {
+        std::vector<AdjusterInstance*>& b = buckets[adj->zone * group_count + adj->group_index];
+        adj->bucket_pos = (int)b.size();
+        b.push_back(adj);
+    }
+
+    void remove(AdjusterInstance* adj) {
+        if (adj->bucket_pos < 0) return;
+        std::vector<AdjusterInstance*>& b = buckets[adj->zone * group_count + adj->group_index];
+        b[adj->bucket_pos] = b.back();
+        b[adj->bucket_pos]->bucket_pos = adj->bucket_pos;
+        b.pop_back();
+        adj->bucket_pos = -1;
+    }
+
+    const std::vector<int>& zonesByDistance(int zone) const { return zone_order[zone]; }
+
+    AdjusterInstance* freeAdjuster(int zone, int group) const {
+        const std::vector<AdjusterInstance*>& b = buckets[zone * group_count + group];
+        return b.empty() ? nullptr : b.back();
+    }
+};
+
+// ------------------- Profiling -------------------
+
+// Heap allocations made by the calling thread so far. Defined in
+// AllocationCounter.cpp, which replaces the global operator new to count
+// them; profiling builds and the benchmarks link it in.
+uint64_t allocationCount();
+
+// Build with -DFMSS_PROFILE to time the simulation phases and count the work
+// done in them; the breakdown is printed after the results. Without the flag
+// the FMSS_PHASE, FMSS_COUNT and FMSS_TRACE_SPAN macros expand to nothing.
+#ifdef FMSS_PROFILE
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#ifdef __linux__
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum ProfilePhase {
+    PHASE_STAFFING, PHASE_DISPATCH, PHASE_MACHINES, PHASE_SHOCKS, PHASE_ADJUSTERS,
+    PHASE_TEAMS, PHASE_SWITCHOVERS, PHASE_RECORD, PHASE_COUNT
+};
+
+enum ProfileCounter {
+    COUNT_EVENTS,       // failures, completed repairs, switchovers, shocks, call-ins/releases
+    COUNT_REQUEUES,     // machines pushed back onto the repair queue by assignAdjusters
+    COUNT_COUNT
+};
+
+// Timestamp counter where available, steady clock nanoseconds elsewhere
+inline uint64_t profileTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+struct Profile {
+    uint64_t ticks[PHASE_COUNT] = {};
+    uint64_t calls[PHASE_COUNT] = {};
+    uint64_t allocations[PHASE_COUNT] = {};
+    uint64_t counters[COUNT_COUNT] = {};
+    uint64_t start_allocations = 0, end_allocations = 0;
+    uint64_t start_ticks = 0, end_ticks = 0;    // run span, to convert ticks to time
+    std::chrono::steady_clock::time_point start_time, end_time;
+
+    // Current day batch of the trace export
+    int batch_days = 1;
+    int batch_first_day = 1;
+    double batch_start_us = 0.0;
+    uint64_t batch_start_ticks = 0;
+    uint64_t batch_phase_ticks[PHASE_COUNT] = {};
+    double run_start_us = 0.0;
+
+    void start() {
+        *this = Profile();
+        start_allocations = allocationCount();
+        start_time = std::chrono::steady_clock::now();
+        start_ticks = profileTicks();
+    }
+
+    void stop() {
+        end_ticks = profileTicks();
+        end_time = std::chrono::steady_clock::now();
+        end_allocations = allocationCount();
+    }
+
+    double nsPerTick() const {
+        double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
+        return end_ticks > start_ticks ? ns / (end_ticks - start_ticks) : 0.0;
+    }
+};
+
+class ScopedPhase {
+private:
+    Profile& profile;
+    ProfilePhase phase;
+    uint64_t start;
+    uint64_t start_allocations;
+
+public:
+    ScopedPhase(Profile& p, ProfilePhase ph) : profile(p), phase(ph), start(profileTicks()), start_allocations(allocationCount()) {}
+    ~ScopedPhase() {
+        profile.ticks[phase] += profileTicks() - start;
+        profile.calls[phase]++;
+        profile.allocations[phase] += allocationCount() - start_allocations;
+    }
+};
+
+// Hardware counters over the simulated days via perf_event_open, enabled by
+// setting FMSS_PERF=1 (Linux only). Each counter is opened on its own for
+// this thread, user space only, so a counter the CPU or kernel refuses does
+// not hide the others; values are scaled if the kernel multiplexed them.
+enum PerfCounterKind { PERF_CYCLES, PERF_INSTRUCTIONS, PERF_CACHE_MISSES, PERF_BRANCH_MISSES, PERF_KIND_COUNT };
+
+class PerfCounters {
+private:
+    int fds[PERF_KIND_COUNT];
+    double values[PERF_KIND_COUNT];
+    std::string error;
+
+public:
+    PerfCounters() {
+        for (int k = 0; k < PERF_KIND_COUNT; ++k) {
+            fds[k] = -1;
+            values[k] = -1.0;
+        }
+    }
+    ~PerfCounters() { close(); }
+
+    static bool requested() {
+        const char* env = std::getenv("FMSS_PERF");
+        return env && strcmp(env, "0") != 0;
+    }
+
+    void start() {
+        close();
+        error.clear();
+#ifdef __linux__
+        static const uint64_t configs[] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+        };
+        for (int k = 0; k < PERF_KIND_COUNT; ++k) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[k];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds[k] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+            if (fds[k] < 0 && error.empty()) {
+                error = strerror(errno);
+                if (errno == EACCES || errno == EPERM) error += "; check /proc/sys/kernel/perf_event_paranoid";
+                else if (errno == ENOENT || errno == EOPNOTSUPP) error += "; the CPU or hypervisor does not expose these counters";
+            }
+        }
+        for (int k = 0; k < PERF_KIND_COUNT; ++k) {
+            if (fds[k] >= 0) {
+                ioctl(fds[k], PERF_EVENT_IOC_RESET, 0);
+                ioctl(fds[k], PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#else
+        error = "perf_event_open is only available on Linux";
+#endif
+    }
+
+    void stop() {
+#ifdef __linux__
+        for (int k = 0; k < PERF_KIND_COUNT; ++k) {
+            if (fds[k] < 0) continue;
+            ioctl(fds[k], PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t data[3];   // value, time enabled, time running
+            if (read(fds[k], data, sizeof(data)) == (ssize_t)sizeof(data) && data[2] > 0) {
+                values[k] = (double)data[0] * data[1] / data[2];
+            }
+        }
+#endif
+        close();
+    }
+
+    // -1 if the counter could not be read
+    double value(PerfCounterKind k) const { return values[k]; }
+    const std::string& openError() const { return error; }
+
+private:
+    void close() {
+#ifdef __linux__
+        for (int k = 0; k < PERF_KIND_COUNT; ++k) {
+            if (fds[k] >= 0) ::close(fds[k]);
+            fds[k] = -1;
+        }
+#endif
+    }
+};
+
+// Chrome trace-event export, enabled by setting FMSS_TRACE to an output
+// path. Every thread appends to its own buffer, so recording takes no lock
+// after a thread's first event; the buffers are merged when the file is
+// written. Open the file in chrome://tracing or ui.perfetto.dev.
+struct TraceEvent {
+    std::string name;
+    std::string category;
+    char phase;             // 'X' span, 'C' counter
+    double ts_us;           // start, microseconds since the trace began
+    double dur_us;
+    std::vector<std::pair<std::string, double>> args;
+};
+
+struct TraceBuffer {
+    int tid;
+    std::string thread_name;
+    std::vector<TraceEvent> events;
+};
+
+class TraceLog {
+private:
+    std::mutex buffers_mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    std::string path;
+
+public:
+    static TraceLog& instance() {
+        static TraceLog log;
+        return log;
+    }
+
+    TraceLog() {
+        const char* env = std::getenv("FMSS_TRACE");
+        if (env) path = env;
+    }
+
+    bool enabled() const { return !path.empty(); }
+
+    double nowUs() const {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    TraceBuffer& threadBuffer() {
+        thread_local TraceBuffer* buffer = nullptr;
+        if (!buffer) {
+            std::lock_guard<std::mutex> lock(buffers_mutex);
+            buffers.push_back(std::make_unique<TraceBuffer>());
+            buffer = buffers.back().get();
+            buffer->tid = (int)buffers.size();
+            buffer->thread_name = buffer->tid == 1 ? "main" : "worker " + std::to_string(buffer->tid - 1);
+        }
+        return *buffer;
+    }
+
+    void span(const std::string& name, const std::string& category, double start_us, double end_us,
+        std::vector<std::pair<std::string, double>> args = {}) {
+        threadBuffer().events.push_back({ name, category, 'X', start_us, end_us - start_us, std::move(args) });
+    }
+
+    void counter(const std::string& name, double ts_us, std::vector<std::pair<std::string, double>> args) {
+        threadBuffer().events.push_back({ name, "counter", 'C', ts_us, 0.0, std::move(args) });
+    }
+
+    // Write every thread's events. Call once the recording threads are done.
+    bool write() {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        std::ofstream out(path);
+        if (!out) return false;
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        out << std::fixed << std::setprecision(3);
+        for (const auto& buffer : buffers) {
+            out << (first ? "" : ",") << "\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"args\":{\"name\":\"" << buffer->thread_name << "\"}}";
+            first = false;
+            for (const TraceEvent& e : buffer->events) {
+                out << ",\n{\"ph\":\"" << e.phase << "\",\"name\":\"" << e.name << "\",\"cat\":\"" << e.category
+                    << "\",\"pid\":1,\"tid\":" << buffer->tid << ",\"ts\":" << e.ts_us;
+                if (e.phase == 'X') out << ",\"dur\":" << e.dur_us;
+                out << ",\"args\":{";
+                for (size_t a = 0; a < e.args.size(); ++a) {
+                    out << (a ? "," : "") << "\"" << e.args[a].first << "\":" << e.args[a].second;
+                }
+                out << "}}";
+            }
+        }
+        out << "\n]}\n";
+        for (auto& buffer : buffers) buffer->events.clear();
+        return bool(out);
+    }
+
+    const std::string& outputPath() const { return path; }
+};
+
+// Records a span on the current thread from construction to destruction
+class TraceSpan {
+private:
+    std::string name, category;
+    double start_us;
+
+public:
+    TraceSpan(std::string n, std::string c) : name(std::move(n)), category(std::move(c)), start_us(0.0) {
+        if (TraceLog::instance().enabled()) start_us = TraceLog::instance().nowUs();
+    }
+    ~TraceSpan() {
+        TraceLog& log = TraceLog::instance();
+        if (log.enabled()) log.span(name, category, start_us, log.nowUs());
+    }
+};
+
+#define FMSS_PHASE(phase) ScopedPhase fmss_phase_scope(profile, phase)
+#define FMSS_COUNT(counter, n) (profile.counters[counter] += (n))
+#define FMSS_TRACE_SPAN(name, category) TraceSpan fmss_trace_span(name, category)
+
+#else
+
+#define FMSS_PHASE(phase) ((void)0)
+#define FMSS_COUNT(counter, n) ((void)0)
+#define FMSS_TRACE_SPAN(name, category) ((void)0)
+
+#endif
+
+
+// ------------------- Library API -------------------
+
+// Everything a simulation is built from. Fill the vectors directly or use
+// the add functions, or read the scenario file format with parseScenario().
+struct Scenario {
+    std::vector<MachineType> machine_types;
+    std::vector<AdjusterGroup> adjuster_groups;
+    std::vector<ProductionLine> production_lines;
+    std::vector<Zone> zones;
+    std::vector<ShockRule> shock_rules;
+    std::vector<CascadeRule> cascade_rules;
+
+    MachineType& addMachineType(const std::string& name, int mttf, int repair_time, int quantity);
+    AdjusterGroup& addAdjusterGroup(const std::string& id, int count, const std::vector<std::string>& capable_machines);
+    // travel_hours: walking time to each zone added before this one
+    Zone& addZone(const std::string& name, const std::vector<double>& travel_hours = {});
+    ProductionLine& addProductionLine(const std::string& name, int throughput, const std::vector<LineStage>& stages);
+    void addShockRule(const ShockRule& rule);
+    void addCascadeRule(const CascadeRule& rule);
+
+    int machineTypeIndex(const std::string& name) const; // -1 if there is none
+    int adjusterGroupIndex(const std::string& id) const; // -1 if there is none
+};
+
+// Read machine types and adjuster groups from the scenario file format into
+// a new scenario; on error `scenario` is left unchanged
+bool parseScenario(std::istream& in, Scenario& scenario, std::string& error);
+
+// Check that a scenario can be simulated: names resolve, sizes and ranges
+// are in bounds. runScenario() calls this first.
+bool validateScenario(const Scenario& scenario, std::string& error);
+
+struct RunOptions {
+    int days = 365;
+    SimulationEngine engine = ENGINE_DAY_STEPPER;
+    unsigned seed = 0;          // seed of replication 0, replication r uses seed + r; 0 = random
+    int replications = 1;
+    int threads = 1;            // replications run in parallel on this many threads, 0 = one per core
+    int recent_events = 10;     // last timeline events kept as text in each result
+    // Run each replication as tasks of this many days, 0 = one task. The
+    // results are the same; shorter tasks let other replications in between
+    // and make stopping quicker.
+    int chunk_days = 0;
+    // Called after every finished replication with the number done so far
+    // and the total; return false to stop the run. Calls come from the
+    // worker threads, one at a time.
+    std::function<bool(int done, int total)> progress;
+};
+
+struct MachineTypeResult {
+    std::string name;
+    int quantity;
+    long long working_days;     // days run since the last repair, summed over machines working at the end
+    double uptime;              // working_days as a percentage of machine-days
+    long long failures;
+    std::vector<long long> mode_failures; // per failure mode, one entry for types without modes
+    int working;                // machines working on the last day
+    int broken;                 // machines broken or under repair on the last day
+    long long spare_swaps;
+    int spares_on_shelf;        // on the last day
+    double failures_per_machine;
+    double mean_virtual_age;    // days, under a Kijima ageing model
+};
+
+struct AdjusterGroupResult {
+    std::string id;
+    int count;
+    long long busy_days;
+    long long available_days;   // days per adjuster: the run, or the days called in for on-call groups
+    double utilization;         // percent
+    int busy;                   // adjusters busy on the last day
+    int call_ins;               // on-call groups only
+    double cost;                // on-call groups: day rate x adjusters x days called in
+};
+
+struct LineResult {
+    std::string name;
+    int stages;
+    long long down_days;
+    int stoppages;
+    long long output;
+    long long lost_output;
+    double availability;        // percent
+};
+
+struct TimelineEntry {
+    int day;
+    std::string text;
+};
+
+// Outcome of one replication
+struct RunResult {
+    unsigned seed;
+    int days;
+    std::vector<MachineTypeResult> machine_types;
+    std::vector<AdjusterGroupResult> adjuster_groups;
+    std::vector<LineResult> lines;
+    double machine_uptime;          // percent over all machines
+    double adjuster_utilization;    // percent over all adjusters
+    long long failures;
+    long long repairs_completed;
+    int max_queue_length;
+    int preemptions;
+    int shocks;
+    long long shock_failures;
+    long long cascade_hazard_raises;
+    long long spare_swaps;
+    double travel_days;             // adjuster days spent walking between zones
+    double contractor_cost;
+    long long plant_output;
+    long long plant_lost;
+    int max_lines_down;
+    long long events;               // timeline events logged
+    long long discrete_events;      // the same without the daily queue-length records
+    uint64_t event_digest;          // hash of the event sequence, equal for identical runs
+    std::vector<TimelineEntry> recent_events;
+#ifdef FMSS_PROFILE
+    Profile profile;
+    bool perf_enabled;
+    double perf[PERF_KIND_COUNT];   // -1 where a counter could not be read
+    std::string perf_error;
+#endif
+};
+
+struct MetricSummary {
+    double mean = 0.0;
+    double stdev = 0.0;     // sample standard deviation, 0 for a single replication
+    double min = 0.0;
+    double max = 0.0;
+};
+
+struct Results {
+    std::vector<RunResult> replications; // in replication order, whatever the thread count
+    MetricSummary machine_uptime;
+    MetricSummary adjuster_utilization;
+    MetricSummary repairs_completed;
+    MetricSummary max_queue_length;
+};
+
+// Simulate the scenario for every replication. Returns false with `error`
+// set if the scenario or the options are invalid, or if progress stopped it.
+bool runScenario(const Scenario& scenario, const RunOptions& options, Results& results, std::string& error);
+
+// One replication with the given seed, as runScenario() runs it on a worker
+// thread, for callers that schedule replications themselves. The scenario
+// must be valid. With `stop`, the run checks it every few simulated days and
+// returns false once it is set.
+bool runReplication(const Scenario& scenario, const RunOptions& options, unsigned seed, RunResult& result,
+    const std::atomic<bool>* stop = nullptr);
+
+class FMSSimulator;
+
+// One replication run a stretch of days at a time; the simulator in between
+// is the checkpoint. runReplication() is one advance() over every day.
+class ReplicationRun {
+private:
+    std::unique_ptr<FMSSimulator> sim;
+    int days;
+    int recent_events;
+    unsigned seed;
+    int day = 0;                // last day simulated
+
+public:
+    ReplicationRun(const Scenario& scenario, const RunOptions& options, unsigned seed);
+    ~ReplicationRun();
+
+    // Simulate up to `max_days` more days (0 = to the end). With `stop`,
+    // checks it every few days; false once it is set, and the run is over.
+    bool advance(int max_days, const std::atomic<bool>* stop = nullptr);
+    bool finished() const { return day >= days; }
+    int daysDone() const { return day; }
+    // Once finished()
+    void finish(RunResult& result);
+};
+
+// Fill the summaries of `results` from its replications
+void summarizeResults(Results& results);
+
+// Setting changed by a sweep; `index` in Sweep picks the machine type or
+// adjuster group
+enum SweepParameter {
+    SWEEP_ADJUSTER_COUNT,
+    SWEEP_MACHINE_QUANTITY,
+    SWEEP_MTTF,
+    SWEEP_REPAIR_TIME,
+    SWEEP_SPARES
+};
+
+struct Sweep {
+    SweepParameter parameter = SWEEP_ADJUSTER_COUNT;
+    int index = 0;
+    std::vector<int> values;    // one sweep point per value
+};
+
+// Run the scenario once per sweep value with the setting replaced, each
+// point with the same options and seeds. The replications of all points
+// share the worker threads; progress counts replications over all points.
+bool runSweep(const Scenario& scenario, const Sweep& sweep, const RunOptions& options,
+    std::vector<Results>& points, std::string& error);
+
+
+// ------------------- Simulator Class -------------------
+
+class FMSSimulator {
+private:
+    std::vector<MachineType> machine_types;
+    std::vector<AdjusterGroup> adjuster_groups;
+    std::vector<ProductionLine> production_lines;
+    std::vector<Zone> zones;
+    std::vector<ShockRule> shock_rules;
+    std::vector<CascadeRule> cascade_rules;
+
+    std::vector<std::vector<MachineInstance>> machines; // per machine type group
+    std::vector<std::vector<AdjusterInstance>> adjusters; // per adjuster group
+
+    RingQueue<MachineInstance*> repair_queue;
+
+    // Line availability, updated on machine state changes
+    LineNetwork lines;
+
+    // In-progress repairs per adjuster group, ordered by machine priority
+    // (priority, adjuster index); only maintained when priorities are in use
+    std::vector<JobHeap> active_jobs;
+    bool preemption_enabled = false;
+    int preemptions = 0;
+
+    // Multi-adjuster repairs in progress
+    std::vector<RepairTeam> teams; // first team_count are in progress, the rest are free slots
+    size_t team_count = 0;
+    int max_crew = 1;
+    std::vector<AdjusterInstance*> crew_buffer;
+    std::vector<AdjusterInstance*> free_buffer; // free adjusters gathered by growTeams
+    int free_adjusters = 0;             // adjusters not busy; callers of startRepair count theirs off
+
+    // Location-aware dispatch, only used once the plant has more than one zone
+    static constexpr double SHIFT_HOURS = 8.0;  // working hours per adjuster day
+    ZoneIndex zone_index;
+    bool zones_enabled = false;
+
+    // Common-cause shocks as their own event stream: (day, shock rule)
+    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> shock_events;
+    std::vector<MachineInstance*> shock_batch;
+    std::vector<std::vector<int>> cascades_by_trigger; // cascade rules per triggering machine type
+    std::vector<int> cascade_dependent;         // dependent machine type per cascade rule
+
+    // Adjuster groups able to repair each (machine type, failure mode), as one
+    // bitset row of cap_words words per mode
+    std::vector<uint64_t> capability_bits;
+    std::vector<int> cap_offset; // first capability row of each machine type
+    int cap_words = 0;
+    std::vector<std::vector<long long>> mode_failures; // failures per machine type and mode
+
+    // Cold standby. The pool is count-based: a type has `spares` shelf records,
+    // and the ones not carrying a unit under repair are the spares available.
+    // A failure with a spare available moves the repair job to a shelf record
+    // and brings the machine back after the switchover time.
+    std::vector<std::vector<MachineInstance>> shelf_records;
+    std::vector<std::vector<MachineInstance*>> free_shelf;
+    // Switchovers in progress as (day, machine type, machine), so machines
+    // due on the same day come back in a fixed order
+    std::priority_queue<std::tuple<int, int, int>, std::vector<std::tuple<int, int, int>>, std::greater<std::tuple<int, int, int>>> switchovers;
+    std::vector<long long> spare_swaps;
+
+    // Dynamic staffing. Queue-length changes move each on-call group's
+    // hysteresis state and schedule a (day, group, generation) check for when
+    // the threshold will have held long enough; a later crossing back bumps
+    // the generation so the stale check is ignored. Nothing polls daily.
+    std::vector<int> on_call_groups;
+    std::vector<char> group_active;
+    std::vector<int> staffing_since;    // day the pending call-in/release condition began, -1 if none
+    std::vector<int> staffing_generation;
+    std::vector<int> active_since;
+    std::vector<long long> active_days;
+    std::vector<int> call_ins;
+    EventHeap<std::tuple<int, int, int>> staffing_events;
+    std::vector<uint64_t> capability_all; // capability bits with every group active
+    int last_queue_length = 0;
+    std::vector<int> shock_resolved_types;      // flattened affected types per shock
+    std::vector<int> shock_type_start;
+    int shocks = 0;
+    long long shock_failures = 0;
+    long long cascade_hazard_raises = 0;
+
+    int simulation_days = 0;
+
+    // Event engine: scheduled failures as (day, machine type, machine). An
+    // entry is stale once the machine stops or gets a new failure day, and is
+    // skipped when popped or dropped when the calendar fills up. Failures on one day come off in (type, machine)
+    // order, the order the day stepper visits machines in, so both engines
+    // draw random numbers in the same sequence and give identical runs.
+    SimulationEngine engine = ENGINE_DAY_STEPPER;
+    EventHeap<std::tuple<int, int, int>> failure_calendar;
+    bool updating_machines = false;
+    std::pair<int, int> machine_cursor; // machine being failed by the calendar
+
+    // Random number generator
+    std::default_random_engine rng;
+
+    // Timeline: ring of the most recent events
+    static constexpr int TIMELINE_CAPACITY = 1024;
+    std::vector<TimelineEvent> timeline;
+    long long timeline_events = 0;
+    long long queue_records = 0;        // EVENT_QUEUE_LENGTH entries among them
+    uint64_t event_digest = 0;          // hash of every event logged, for comparing runs
+
+    // For max queue length tracking
+    int max_queue_length = 0;
+    long long repairs_completed = 0;
+
+#ifdef FMSS_PROFILE
+    Profile profile;
+    PerfCounters perf;
+    bool perf_enabled = false;
+#endif
+
+public:
+    FMSSimulator();
+    explicit FMSSimulator(const Scenario& scenario);
+    void setScenario(const Scenario& scenario);
+    void initializeSimulation();
+    int randomizedFailureDay(int mttf);
+    int sampleFailureDay(const MachineType& mt, const MachineInstance& m, int start_day);
+    double failureAge(const MachineType& mt, const MachineInstance& m);
+    void ageMachine(const MachineType& mt, MachineInstance& m, int ran_days, int end_day);
+    int pickFailureMode(const MachineType& mt);
+    int repairTime(const MachineInstance* m) const;
+    void buildCapabilities();
+    const uint64_t* capableGroups(const MachineInstance* m) const;
+    void setGroupActive(int g, bool active);
+    void queueLengthChanged(int current_day);
+    void processStaffingEvents(int current_day);
+    bool canRepair(int g, const MachineInstance* m) const;
+    bool canAdjusterServiceMachine(int adj_group_index, const std::string& machine_name);
+    void simulate(int days);
+    void startSimulation(int days);
+    void logEvent(int day, TimelineKind kind, int a = 0, int b = 0, int c = 0, int d = 0, int e = 0);
+    std::string describeEvent(const TimelineEvent& ev) const;
+    void simulateDay(int day);
+
+#ifdef FMSS_PROFILE
+    void traceDayBatch(int day);
+#endif
+
+    void recordDay(int day);
+    void finishSimulation();
+    void setSeed(unsigned seed);
+    void setEngine(SimulationEngine e);
+    RunResult result(int recent_events) const;
+
+    uint64_t eventDigest() const { return event_digest; }
+    long long eventCount() const { return timeline_events; }
+    long long preemptionCount() const { return preemptions; }
+    int maxQueueLength() const { return max_queue_length; }
+
+    long long failureCount() const;
+
+    long long repairCount() const { return repairs_completed; }
+
+    void assignAdjusters(int current_day);
+    AdjusterInstance* nearestFreeAdjuster(const MachineInstance* m);
+    int travelDays(const AdjusterInstance& adj, const MachineInstance* m) const;
+    int travelTo(AdjusterInstance& adj, const MachineInstance* m);
+    bool startTeamRepair(MachineInstance* m, int current_day);
+    static int teamFinishDay(double work_left, double rate, int from_day);
+    void growTeams(int current_day);
+    void updateTeams(int current_day);
+    void startRepair(AdjusterInstance& adj, MachineInstance* m, int current_day);
+    bool preemptRepair(MachineInstance* m, int current_day);
+    void updateMachines(int current_day);
+    void failScheduledMachines(int current_day);
+    void scheduleFailure(const MachineInstance& m);
+    int runningDays(const MachineInstance& m, int current_day) const;
+    void failMachine(MachineInstance& m, int current_day);
+    void processSwitchovers(int current_day);
+    int nextShockDay(const ShockRule& rule, int after_day);
+    void processShocks(int current_day);
+    void applyCascades(int trigger, int current_day);
+    void updateAdjusters(int current_day);
+    void returnToService(MachineInstance* m, int current_day);
+};
+
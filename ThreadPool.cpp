@@ -0,0 +1,105 @@
+#include "ThreadPool.h"
+
+using namespace std;
+
+// The pool and deque index of the calling thread, if it is one of a pool's
+// workers
+static thread_local const WorkStealingPool* current_pool = nullptr;
+static thread_local int current_index = -1;
+
+WorkStealingPool::WorkStealingPool(int thread_count) {
+    thread_count = max(1, thread_count);
+    for (int w = 0; w < thread_count; ++w) workers.push_back(make_unique<Worker>());
+    for (int w = 1; w < thread_count; ++w) threads.emplace_back(&WorkStealingPool::workerLoop, this, w);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        lock_guard<mutex> lock(signal_mutex);
+        stopping = true;
+    }
+    signal.notify_all();
+    for (thread& t : threads) t.join();
+}
+
+int WorkStealingPool::currentWorker() const {
+    return current_pool == this ? current_index : -1;
+}
+
+void WorkStealingPool::submit(Task task) {
+    int self = currentWorker();
+    int w = self >= 0 ? self : (int)(next_worker++ % workers.size());
+    unfinished++;
+    {
+        lock_guard<mutex> lock(workers[w]->m);
+        workers[w]->tasks.push_back(move(task));
+    }
+    queued++;
+    // Through the signal mutex so a worker about to sleep cannot miss it
+    { lock_guard<mutex> lock(signal_mutex); }
+    signal.notify_one();
+}
+
+// Own deque from the back, then the others from the front, nearest first
+bool WorkStealingPool::take(int self, Task& task) {
+    int n = (int)workers.size();
+    for (int i = 0; i < n; ++i) {
+        Worker& w = *workers[(self + i) % n];
+        lock_guard<mutex> lock(w.m);
+        if (w.tasks.empty()) continue;
+        if (i == 0) {
+            task = move(w.tasks.back());
+            w.tasks.pop_back();
+        }
+        else {
+            task = move(w.tasks.front());
+            w.tasks.pop_front();
+        }
+        queued--;
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::runTask(Task& task) {
+    task();
+    task = nullptr;
+    if (--unfinished == 0) {
+        { lock_guard<mutex> lock(signal_mutex); }
+        signal.notify_all();
+    }
+}
+
+void WorkStealingPool::workerLoop(int self) {
+    current_pool = this;
+    current_index = self;
+    Task task;
+    while (true) {
+        if (take(self, task)) {
+            runTask(task);
+            continue;
+        }
+        unique_lock<mutex> lock(signal_mutex);
+        signal.wait(lock, [&]() { return stopping || queued > 0; });
+        if (stopping) return;
+    }
+}
+
+void WorkStealingPool::wait() {
+    const WorkStealingPool* outer_pool = current_pool;
+    int outer_index = current_index;
+    current_pool = this;
+    current_index = 0;
+    Task task;
+    while (true) {
+        if (take(0, task)) {
+            runTask(task);
+            continue;
+        }
+        unique_lock<mutex> lock(signal_mutex);
+        signal.wait(lock, [&]() { return queued > 0 || unfinished == 0; });
+        if (unfinished == 0) break;
+    }
+    current_pool = outer_pool;
+    current_index = outer_index;
+}
@@ -0,0 +1,60 @@
+// Work-stealing pool for simulation tasks of very uneven cost. Replications
+// and sweep points differ by orders of magnitude (one adjuster with a long
+// queue against fifty idle ones), so no split fixed up front keeps every
+// core busy to the end.
+//
+// Each worker has its own deque. A task submitted from a worker goes on the
+// back of that worker's deque, and the worker takes its next task from the
+// back, so a follow-on task (the next chunk of a replication) runs while
+// its data is still in cache. A worker whose deque is empty steals from the
+// front of another's, where the oldest and usually largest work sits.
+// Tasks submitted from outside are dealt round-robin over the deques.
+//
+// The thread that calls wait() is worker 0 and runs tasks until everything
+// submitted is done; the pool starts threads - 1 more.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+private:
+    struct Worker {
+        std::mutex m;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers; // [0] belongs to the thread in wait()
+    std::vector<std::thread> threads;
+    std::atomic<int> queued{ 0 };           // tasks sitting in the deques
+    std::atomic<int> unfinished{ 0 };       // submitted and not yet finished
+    std::atomic<unsigned> next_worker{ 0 }; // round-robin target of outside submissions
+    std::mutex signal_mutex;
+    std::condition_variable signal;         // work queued, all work done, or stopping
+    bool stopping = false;
+
+    bool take(int self, Task& task);
+    void runTask(Task& task);
+    void workerLoop(int self);
+    int currentWorker() const;
+
+public:
+    explicit WorkStealingPool(int threads);     // including the one that will call wait()
+    ~WorkStealingPool();
+
+    void submit(Task task);
+    // Run tasks on the calling thread until every submitted task, and every
+    // task those submitted, has finished
+    void wait();
+    int size() const { return (int)workers.size(); }
+};
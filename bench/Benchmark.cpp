@@ -0,0 +1,333 @@
+// Micro-benchmarks for the simulator hot paths.
+//
+// Build:  cmake --build build --target fmss_bench
+// Run:    ./fmss_bench [--quick] [--reps N] [--filter TEXT]
+//         ./fmss_bench --check-allocations
+//
+// Every result is printed as one JSON object per line so runs can be stored
+// and compared against a baseline with tools/BenchCompare.cpp. Times are
+// medians over the repetitions; the per-repetition samples are included for
+// noise estimates.
+//
+// --check-allocations runs a set of factories past a warm-up period and
+// fails (exit 1) if the simulation loop allocates any heap memory after it.
+
+#include "../Simulator.h"
+#include "../tools/ScenarioGenerator.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+// ------------------- Synthetic factories -------------------
+
+struct FactorySpec {
+    string name;
+    GeneratorOptions factory;
+    int days;           // simulated days per run
+    bool teams = false; // every other machine type repaired by crews of up to three
+};
+
+void useTeams(Scenario& scenario, int types) {
+    for (int t = 0; t < types; t += 2) {
+        scenario.machine_types[t].max_crew = 3;
+        scenario.machine_types[t].crew_speedup = { 1.6, 2.0 };
+    }
+}
+
+// Factories come from the scenario generator with a fixed seed, so every
+// build benchmarks the same factory
+Scenario buildFactory(const FactorySpec& spec) {
+    stringstream text;
+    generateScenario(text, spec.factory);
+    Scenario scenario;
+    string error;
+    if (!parseScenario(text, scenario, error)) throw runtime_error("generated scenario rejected: " + error);
+    if (spec.teams) useTeams(scenario, spec.factory.types);
+    return scenario;
+}
+
+FactorySpec makeSpec(const string& name, int types, int machines, int groups, int adjusters,
+    OverlapPattern overlap, double density, int days) {
+    FactorySpec spec{ name, GeneratorOptions(), days };
+    spec.factory.seed = 12345;
+    spec.factory.types = types;
+    spec.factory.machines = machines;
+    spec.factory.groups = groups;
+    spec.factory.adjusters = adjusters;
+    spec.factory.overlap = overlap;
+    spec.factory.overlap_density = density;
+    return spec;
+}
+
+vector<FactorySpec> factorySpecs(bool quick) {
+    vector<FactorySpec> specs;
+    // Fleet size, one adjuster per 100 machines; days keep machine-days near 36M
+    for (int machines : { 10, 1000, 100000, 1000000 }) {
+        if (quick && machines > 1000) break;
+        int adjusters = min(max(machines / 100, 1), 1000);
+        int days = max(30, min(3650, 36500000 / machines));
+        specs.push_back(makeSpec("fleet_" + to_string(machines), min(machines, 20), machines, min(adjusters, 10),
+            adjusters, OVERLAP_RANDOM, 0.5, days));
+    }
+    // Staffing, 10k machines, then the same with team repairs
+    for (bool teams : { false, true }) {
+        for (int adjusters : { 1, 10, 100, 1000 }) {
+            if (quick && adjusters > 10) break;
+            specs.push_back(makeSpec("staff_" + to_string(adjusters) + (teams ? "_teams" : ""), 20, 10000,
+                min(adjusters, 10), adjusters, OVERLAP_RANDOM, 0.5, quick ? 365 : 1825));
+            specs.back().teams = teams;
+        }
+    }
+    // Capability overlap between groups
+    for (double overlap : { 0.1, 0.5, 1.0 }) {
+        char name[32];
+        snprintf(name, sizeof(name), "overlap_%.1f", overlap);
+        specs.push_back(makeSpec(name, 50, 10000, 20, 100, OVERLAP_RANDOM, overlap, quick ? 365 : 1825));
+    }
+    specs.push_back(makeSpec("overlap_disjoint", 50, 10000, 20, 100, OVERLAP_DISJOINT, 0.0, quick ? 365 : 1825));
+    specs.push_back(makeSpec("overlap_nested", 50, 10000, 20, 100, OVERLAP_NESTED, 0.0, quick ? 365 : 1825));
+    return specs;
+}
+
+// ------------------- Measurement -------------------
+
+using Clock = chrono::steady_clock;
+
+static double elapsedNs(Clock::time_point a, Clock::time_point b) {
+    return (double)chrono::duration_cast<chrono::nanoseconds>(b - a).count();
+}
+
+static double median(vector<double> v) {
+    sort(v.begin(), v.end());
+    size_t n = v.size();
+    return n % 2 ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+}
+
+struct Result {
+    string bench;
+    const FactorySpec* spec;
+    string unit;                // "ns_per_day" or "ns_per_call"
+    vector<double> samples;
+    double events_per_sec;      // 0 when not applicable
+    double allocs_per_event = -1.0;
+};
+
+void printResult(const Result& r) {
+    cout << "{\"bench\":\"" << r.bench << "\"";
+    if (r.spec) {
+        static const char* patterns[] = { "disjoint", "nested", "random" };
+        const GeneratorOptions& f = r.spec->factory;
+        cout << ",\"factory\":\"" << r.spec->name << "\",\"machines\":" << f.machines << ",\"types\":" << f.types
+            << ",\"adjusters\":" << f.adjusters << ",\"groups\":" << f.groups << ",\"overlap\":\"" << patterns[f.overlap]
+            << "\",\"density\":" << fixed << setprecision(2) << f.overlap_density << ",\"days\":" << r.spec->days;
+    }
+    cout << ",\"unit\":\"" << r.unit << "\",\"median\":" << fixed << setprecision(1) << median(r.samples)
+        << ",\"min\":" << *min_element(r.samples.begin(), r.samples.end());
+    if (r.events_per_sec > 0) cout << ",\"events_per_sec\":" << setprecision(0) << r.events_per_sec;
+    if (r.allocs_per_event >= 0) cout << ",\"allocs_per_event\":" << setprecision(4) << r.allocs_per_event;
+    cout << ",\"samples\":[";
+    for (size_t i = 0; i < r.samples.size(); ++i) {
+        cout << (i ? "," : "") << setprecision(1) << r.samples[i];
+    }
+    cout << "]}" << endl;
+}
+
+// Full runs through simulate(): the cost of a simulated day end to end
+Result benchRun(const FactorySpec& spec, int reps) {
+    Result r{ "runSimulation", &spec, "ns_per_day", {}, 0.0 };
+    vector<double> events_rate;
+    for (int rep = 0; rep < reps; ++rep) {
+        FMSSimulator sim(buildFactory(spec));
+        sim.setSeed(777);
+
+        uint64_t a0 = allocationCount();
+        Clock::time_point t0 = Clock::now();
+        sim.simulate(spec.days);
+        Clock::time_point t1 = Clock::now();
+        uint64_t a1 = allocationCount();
+
+        double ns = elapsedNs(t0, t1);
+        long long events = sim.failureCount() + sim.repairCount();
+        r.samples.push_back(ns / spec.days);
+        events_rate.push_back(events / (ns * 1e-9));
+        if (events > 0) r.allocs_per_event = (double)(a1 - a0) / events;
+    }
+    r.events_per_sec = median(events_rate);
+    return r;
+}
+
+// The day loop with each phase timed on its own. Mirrors simulateDay for
+// factories without shocks, team repairs, spares or on-call groups, so it is
+// not run on the team factories.
+vector<Result> benchPhases(const FactorySpec& spec, int reps) {
+    const char* names[] = { "assignAdjusters", "updateMachines", "updateAdjusters", "recordDay" };
+    vector<Result> results;
+    for (const char* name : names) results.push_back({ name, &spec, "ns_per_day", {}, 0.0 });
+
+    for (int rep = 0; rep < reps; ++rep) {
+        FMSSimulator sim(buildFactory(spec));
+        sim.setSeed(777);
+
+        sim.startSimulation(spec.days);
+        double total[4] = { 0, 0, 0, 0 };
+        for (int day = 1; day <= spec.days; ++day) {
+            Clock::time_point t0 = Clock::now();
+            sim.assignAdjusters(day);
+            Clock::time_point t1 = Clock::now();
+            sim.updateMachines(day);
+            Clock::time_point t2 = Clock::now();
+            sim.updateAdjusters(day);
+            Clock::time_point t3 = Clock::now();
+            sim.recordDay(day);
+            Clock::time_point t4 = Clock::now();
+            total[0] += elapsedNs(t0, t1);
+            total[1] += elapsedNs(t1, t2);
+            total[2] += elapsedNs(t2, t3);
+            total[3] += elapsedNs(t3, t4);
+        }
+        sim.finishSimulation();
+
+        for (int p = 0; p < 4; ++p) results[p].samples.push_back(total[p] / spec.days);
+    }
+    return results;
+}
+
+Result benchFailureDraw(int reps) {
+    const int calls = 1000000;
+    Result r{ "randomizedFailureDay", nullptr, "ns_per_call", {}, 0.0 };
+    FMSSimulator sim;
+    sim.setSeed(777);
+    long long sink = 0;
+    for (int rep = 0; rep < reps; ++rep) {
+        Clock::time_point t0 = Clock::now();
+        for (int i = 0; i < calls; ++i) sink += sim.randomizedFailureDay(30 + (i & 255));
+        Clock::time_point t1 = Clock::now();
+        r.samples.push_back(elapsedNs(t0, t1) / calls);
+    }
+    if (sink == 42) cerr << "";     // keep the draws from being optimized away
+    return r;
+}
+
+// ------------------- Allocation check -------------------
+
+// Day loop allocations after a warm-up year, for the generated factories and
+// each model feature on top of them, under both engines
+static const char* ALLOCATION_VARIANTS[] = { "base", "priorities", "teams", "zones", "shocks", "spares", "on-call" };
+
+void applyVariant(Scenario& scenario, const FactorySpec& spec, int variant) {
+    int types = spec.factory.types;
+    if (variant == 1) {
+        for (int t = 0; t < types; t += 2) scenario.machine_types[t].priority = 1 + t % 3;
+    }
+    else if (variant == 2) {
+        useTeams(scenario, types);
+    }
+    else if (variant == 3) {
+        scenario.addZone("hall A");
+        scenario.addZone("hall B", { 1.5 });
+        scenario.addZone("yard", { 4.0, 2.5 });
+        for (MachineType& mt : scenario.machine_types) {
+            mt.machine_zones.resize(mt.quantity);
+            for (int q = 0; q < mt.quantity; ++q) mt.machine_zones[q] = q % 3;
+        }
+        for (size_t g = 0; g < scenario.adjuster_groups.size(); ++g) scenario.adjuster_groups[g].home_zone = g % 3;
+    }
+    else if (variant == 4) {
+        vector<string> hit;
+        for (int t = 0; t < types; t += 3) hit.push_back(scenario.machine_types[t].name);
+        scenario.addShockRule(ShockRule("power dip", 30.0, 0.05, hit));
+        for (int t = 0; t + 1 < types; t += 4) {
+            scenario.addCascadeRule(CascadeRule(scenario.machine_types[t].name, scenario.machine_types[t + 1].name, 3.0, 20));
+        }
+    }
+    else if (variant == 5) {
+        for (int t = 0; t < types; t += 2) {
+            scenario.machine_types[t].spares = max(1, scenario.machine_types[t].quantity / 50);
+            scenario.machine_types[t].switchover_days = t % 4 ? 0 : 2;
+        }
+    }
+    else if (variant == 6) {
+        vector<string> all;
+        for (const MachineType& mt : scenario.machine_types) all.push_back(mt.name);
+        AdjusterGroup& contractors = scenario.addAdjusterGroup("contractors", max(1, spec.factory.adjusters / 4), all);
+        contractors.on_call = true;
+        contractors.call_in_queue = 5;
+        contractors.call_in_days = 3;
+        contractors.release_queue = 1;
+        contractors.release_days = 5;
+    }
+}
+
+bool checkAllocations() {
+    const int warmup_days = 365, measured_days = 730;
+    bool ok = true;
+    for (const FactorySpec& spec : factorySpecs(true)) {
+        if (spec.teams) continue;           // the "teams" variant covers them
+        for (int variant = 0; variant < 7; ++variant) {
+            for (SimulationEngine engine : { ENGINE_DAY_STEPPER, ENGINE_EVENT_CALENDAR }) {
+                Scenario scenario = buildFactory(spec);
+                applyVariant(scenario, spec, variant);
+                FMSSimulator sim(scenario);
+                sim.setSeed(777);
+                sim.setEngine(engine);
+
+                sim.startSimulation(warmup_days + measured_days);
+                for (int day = 1; day <= warmup_days; ++day) sim.simulateDay(day);
+                uint64_t a0 = allocationCount();
+                for (int day = warmup_days + 1; day <= warmup_days + measured_days; ++day) sim.simulateDay(day);
+                uint64_t allocations = allocationCount() - a0;
+                sim.finishSimulation();
+
+                cout << (allocations == 0 ? "ok    " : "FAIL  ") << spec.name << " (" << ALLOCATION_VARIANTS[variant]
+                    << (engine == ENGINE_EVENT_CALENDAR ? ", calendar" : "") << "): "
+                    << allocations << " allocations in " << measured_days << " days after warm-up\n";
+                ok = ok && allocations == 0;
+            }
+        }
+    }
+    return ok;
+}
+
+// ------------------- Main -------------------
+
+int main(int argc, char** argv) {
+    bool quick = false, check_allocations = false;
+    int reps = 5;
+    string filter;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--quick")) quick = true;
+        else if (!strcmp(argv[i], "--check-allocations")) check_allocations = true;
+        else if (!strcmp(argv[i], "--reps") && i + 1 < argc) reps = max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc) filter = argv[++i];
+        else {
+            cerr << "usage: " << argv[0] << " [--quick] [--reps N] [--filter TEXT] | --check-allocations\n";
+            return 2;
+        }
+    }
+    if (check_allocations) return checkAllocations() ? 0 : 1;
+    if (quick) reps = min(reps, 3);
+
+    auto selected = [&](const string& name) { return filter.empty() || name.find(filter) != string::npos; };
+
+    if (selected("randomizedFailureDay")) printResult(benchFailureDraw(reps));
+
+    vector<FactorySpec> specs = factorySpecs(quick);
+    for (const FactorySpec& spec : specs) {
+        if (selected("runSimulation") || selected(spec.name)) {
+            printResult(benchRun(spec, reps));
+        }
+        if (!spec.teams && (selected("assignAdjusters") || selected("updateMachines") || selected("updateAdjusters")
+            || selected("recordDay") || selected(spec.name))) {
+            for (const Result& r : benchPhases(spec, reps)) {
+                if (selected(r.bench) || selected(spec.name)) printResult(r);
+            }
+        }
+    }
+    return 0;
+}
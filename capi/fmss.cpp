@@ -0,0 +1,299 @@
+// C interface over the library API: handles wrap Scenario and Results, and
+// every entry point turns errors and exceptions into fmss_last_error().
+
+#include "fmss.h"
+#include "../Simulator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+using namespace std;
+
+struct fmss_scenario {
+    Scenario scenario;
+};
+
+struct fmss_result {
+    Results results;
+};
+
+static thread_local string last_error;
+
+static int32_t fail(const string& error) {
+    last_error = error;
+    return -1;
+}
+
+// Runs `body`, turning exceptions (bad_alloc, mostly) into an error return
+template <class F>
+static auto guarded(F body, decltype(body()) on_error) -> decltype(body()) {
+    try {
+        return body();
+    }
+    catch (const exception& e) {
+        last_error = e.what();
+    }
+    catch (...) {
+        last_error = "unknown error";
+    }
+    return on_error;
+}
+
+// Copy the leading `size` bytes both sides know: a caller built against an
+// older header passes a shorter struct, a newer one a longer struct
+template <class T>
+static void copyIn(T& to, const void* from, uint32_t size) {
+    memcpy(&to, from, min<size_t>(size, sizeof(T)));
+}
+
+template <class T>
+static void copyOut(void* to, const T& from, uint32_t size) {
+    memcpy(to, &from, min<size_t>(size, sizeof(T)));
+}
+
+// Entry i of a caller's array of `size`-byte elements
+static void* element(void* out, uint32_t size, int32_t i) {
+    return (char*)out + (size_t)size * i;
+}
+
+static bool toRunOptions(const fmss_run_options* options, fmss_progress_fn progress, void* user, RunOptions& out) {
+    if (!options || options->struct_size < sizeof(uint32_t)) return false;
+    fmss_run_options given;                 // fields the caller does not know keep their defaults
+    fmss_run_options_init(&given, sizeof given);
+    copyIn(given, options, options->struct_size);
+    const fmss_run_options* in = &given;
+    if (in->engine != FMSS_ENGINE_DAY_STEPPER && in->engine != FMSS_ENGINE_EVENT_CALENDAR) return false;
+    out.days = in->days;
+    out.engine = (SimulationEngine)in->engine;
+    out.seed = in->seed;
+    out.replications = in->replications;
+    out.threads = in->threads;
+    out.recent_events = 0;
+    if (progress) out.progress = [progress, user](int done, int total) { return progress(done, total, user) == 0; };
+    return true;
+}
+
+static void toMetric(const MetricSummary& in, fmss_metric& out) {
+    out.mean = in.mean;
+    out.stdev = in.stdev;
+    out.min = in.min;
+    out.max = in.max;
+}
+
+static void toSummary(const Results& in, fmss_summary& out) {
+    out.replications = (int32_t)in.replications.size();
+    toMetric(in.machine_uptime, out.machine_uptime);
+    toMetric(in.adjuster_utilization, out.adjuster_utilization);
+    toMetric(in.repairs_completed, out.repairs_completed);
+    toMetric(in.max_queue_length, out.max_queue_length);
+}
+
+// ------------------- Scenarios -------------------
+
+int32_t fmss_abi_version(void) {
+    return FMSS_ABI_VERSION;
+}
+
+const char* fmss_last_error(void) {
+    return last_error.c_str();
+}
+
+fmss_scenario* fmss_scenario_new(void) {
+    return guarded([]() { return new fmss_scenario(); }, (fmss_scenario*)nullptr);
+}
+
+void fmss_scenario_free(fmss_scenario* scenario) {
+    delete scenario;
+}
+
+int32_t fmss_scenario_parse(fmss_scenario* scenario, const char* text) {
+    if (!scenario || !text) return fail("no scenario or text");
+    return guarded([&]() -> int32_t {
+        istringstream in(text);
+        string error;
+        if (!parseScenario(in, scenario->scenario, error)) return fail(error);
+        return 0;
+    }, -1);
+}
+
+int32_t fmss_scenario_add_machine_type(fmss_scenario* scenario, const char* name,
+    int32_t mttf_days, int32_t repair_days, int32_t quantity) {
+    if (!scenario || !name || !*name) return fail("no scenario or machine type name");
+    if (mttf_days < 1 || repair_days < 1 || quantity < 1) return fail("MTTF, repair time and quantity must be at least 1");
+    return guarded([&]() -> int32_t {
+        Scenario& s = scenario->scenario;
+        if (s.machineTypeIndex(name) >= 0) return fail("duplicate machine type \"" + string(name) + "\"");
+        s.addMachineType(name, mttf_days, repair_days, quantity);
+        return (int32_t)s.machine_types.size() - 1;
+    }, -1);
+}
+
+int32_t fmss_scenario_add_adjuster_group(fmss_scenario* scenario, const char* id, int32_t count,
+    const char* const* machine_types, int32_t machine_type_count) {
+    if (!scenario || !id || !*id) return fail("no scenario or adjuster group id");
+    if (count < 1) return fail("an adjuster group needs at least one adjuster");
+    if (machine_type_count < 0 || (machine_type_count > 0 && !machine_types)) return fail("no machine type list");
+    return guarded([&]() -> int32_t {
+        Scenario& s = scenario->scenario;
+        if (s.adjusterGroupIndex(id) >= 0) return fail("duplicate adjuster group \"" + string(id) + "\"");
+        vector<string> capable;
+        for (int32_t i = 0; i < machine_type_count; ++i) {
+            if (!machine_types[i] || s.machineTypeIndex(machine_types[i]) < 0) {
+                return fail("adjuster group \"" + string(id) + "\": unknown machine type");
+            }
+            capable.push_back(machine_types[i]);
+        }
+        s.addAdjusterGroup(id, count, capable);
+        return (int32_t)s.adjuster_groups.size() - 1;
+    }, -1);
+}
+
+int32_t fmss_scenario_machine_type_count(const fmss_scenario* scenario) {
+    if (!scenario) return fail("no scenario");
+    return (int32_t)scenario->scenario.machine_types.size();
+}
+
+int32_t fmss_scenario_adjuster_group_count(const fmss_scenario* scenario) {
+    if (!scenario) return fail("no scenario");
+    return (int32_t)scenario->scenario.adjuster_groups.size();
+}
+
+// ------------------- Runs -------------------
+
+void fmss_run_options_init(fmss_run_options* options, uint32_t struct_size) {
+    if (!options || struct_size < sizeof(uint32_t)) return;
+    RunOptions defaults;
+    fmss_run_options o;
+    o.struct_size = struct_size;
+    o.days = defaults.days;
+    o.engine = (int32_t)defaults.engine;
+    o.seed = defaults.seed;
+    o.replications = defaults.replications;
+    o.threads = defaults.threads;
+    copyOut(options, o, struct_size);
+}
+
+fmss_result* fmss_run(const fmss_scenario* scenario, const fmss_run_options* options,
+    fmss_progress_fn progress, void* user) {
+    RunOptions run;
+    if (!scenario || !toRunOptions(options, progress, user, run)) {
+        fail("no scenario or invalid run options");
+        return nullptr;
+    }
+    return guarded([&]() -> fmss_result* {
+        fmss_result* result = new fmss_result();
+        string error;
+        if (!runScenario(scenario->scenario, run, result->results, error)) {
+            delete result;
+            fail(error);
+            return nullptr;
+        }
+        return result;
+    }, nullptr);
+}
+
+int32_t fmss_sweep(const fmss_scenario* scenario, int32_t parameter, int32_t index,
+    const int32_t* values, int32_t value_count, const fmss_run_options* options,
+    fmss_summary* summaries, uint32_t summary_size, fmss_progress_fn progress, void* user) {
+    RunOptions run;
+    if (!scenario || !toRunOptions(options, progress, user, run)) return fail("no scenario or invalid run options");
+    if (parameter < FMSS_SWEEP_ADJUSTER_COUNT || parameter > FMSS_SWEEP_SPARES) return fail("unknown sweep parameter");
+    if (value_count < 1 || !values || !summaries || summary_size == 0) return fail("no sweep values or summary buffer");
+    return guarded([&]() -> int32_t {
+        Sweep sweep;
+        sweep.parameter = (SweepParameter)parameter;
+        sweep.index = index;
+        sweep.values.assign(values, values + value_count);
+        vector<Results> points;
+        string error;
+        if (!runSweep(scenario->scenario, sweep, run, points, error)) return fail(error);
+        for (int32_t p = 0; p < value_count; ++p) {
+            fmss_summary o;
+            toSummary(points[p], o);
+            copyOut(element(summaries, summary_size, p), o, summary_size);
+        }
+        return 0;
+    }, -1);
+}
+
+// ------------------- Results -------------------
+
+void fmss_result_free(fmss_result* result) {
+    delete result;
+}
+
+int32_t fmss_result_summary(const fmss_result* result, fmss_summary* summary, uint32_t summary_size) {
+    if (!result || !summary || summary_size == 0) return fail("no result or summary buffer");
+    fmss_summary o;
+    toSummary(result->results, o);
+    copyOut(summary, o, summary_size);
+    return 0;
+}
+
+int32_t fmss_result_replications(const fmss_result* result,
+    fmss_replication_stats* out, uint32_t element_size, int32_t capacity) {
+    if (!result || capacity < 0 || (capacity > 0 && (!out || element_size == 0))) return fail("no result or buffer");
+    const vector<RunResult>& runs = result->results.replications;
+    for (int32_t r = 0; r < capacity && r < (int32_t)runs.size(); ++r) {
+        const RunResult& in = runs[r];
+        fmss_replication_stats o;
+        o.seed = in.seed;
+        o.days = in.days;
+        o.max_queue_length = in.max_queue_length;
+        o.preemptions = in.preemptions;
+        o.max_lines_down = in.max_lines_down;
+        o.failures = in.failures;
+        o.repairs_completed = in.repairs_completed;
+        o.plant_output = in.plant_output;
+        o.plant_lost = in.plant_lost;
+        o.events = in.events;
+        o.event_digest = in.event_digest;
+        o.machine_uptime = in.machine_uptime;
+        o.adjuster_utilization = in.adjuster_utilization;
+        o.contractor_cost = in.contractor_cost;
+        copyOut(element(out, element_size, r), o, element_size);
+    }
+    return (int32_t)runs.size();
+}
+
+int32_t fmss_result_machine_types(const fmss_result* result, int32_t replication,
+    fmss_machine_type_stats* out, uint32_t element_size, int32_t capacity) {
+    if (!result || capacity < 0 || (capacity > 0 && (!out || element_size == 0))) return fail("no result or buffer");
+    if (replication < 0 || replication >= (int32_t)result->results.replications.size()) return fail("no such replication");
+    const vector<MachineTypeResult>& types = result->results.replications[replication].machine_types;
+    for (int32_t t = 0; t < capacity && t < (int32_t)types.size(); ++t) {
+        const MachineTypeResult& in = types[t];
+        fmss_machine_type_stats o;
+        o.quantity = in.quantity;
+        o.working = in.working;
+        o.broken = in.broken;
+        o.spares_on_shelf = in.spares_on_shelf;
+        o.failures = in.failures;
+        o.spare_swaps = in.spare_swaps;
+        o.uptime = in.uptime;
+        o.failures_per_machine = in.failures_per_machine;
+        copyOut(element(out, element_size, t), o, element_size);
+    }
+    return (int32_t)types.size();
+}
+
+int32_t fmss_result_adjuster_groups(const fmss_result* result, int32_t replication,
+    fmss_adjuster_group_stats* out, uint32_t element_size, int32_t capacity) {
+    if (!result || capacity < 0 || (capacity > 0 && (!out || element_size == 0))) return fail("no result or buffer");
+    if (replication < 0 || replication >= (int32_t)result->results.replications.size()) return fail("no such replication");
+    const vector<AdjusterGroupResult>& groups = result->results.replications[replication].adjuster_groups;
+    for (int32_t g = 0; g < capacity && g < (int32_t)groups.size(); ++g) {
+        const AdjusterGroupResult& in = groups[g];
+        fmss_adjuster_group_stats o;
+        o.count = in.count;
+        o.busy = in.busy;
+        o.call_ins = in.call_ins;
+        o.busy_days = in.busy_days;
+        o.available_days = in.available_days;
+        o.utilization = in.utilization;
+        o.cost = in.cost;
+        copyOut(element(out, element_size, g), o, element_size);
+    }
+    return (int32_t)groups.size();
+}
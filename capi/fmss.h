@@ -0,0 +1,186 @@
+/* C interface of the Factory Maintenance Optimization Simulator (libfmss).
+ *
+ * Build:  cmake --build build --target fmss      (gives libfmss.so)
+ *
+ * Scenarios and results are opaque handles created and freed through this
+ * interface. Result data is copied into buffers the caller owns: the array
+ * functions take a capacity and return the number of entries available, so
+ * a call with capacity 0 sizes the buffer.
+ *
+ * Every struct crossing the interface comes with its size as the caller
+ * compiled it: fmss_run_options carries it in struct_size (set by
+ * fmss_run_options_init), output buffers take it as an element_size
+ * argument. Structs only grow at the end, and the library reads and writes
+ * only the leading bytes both sides know, so a caller built against an
+ * older header keeps working with a newer library: missing options take
+ * their defaults and newer result fields are left out. fmss_metric is
+ * embedded in fmss_summary and never changes. Any other layout change bumps
+ * FMSS_ABI_VERSION; refuse to run when fmss_abi_version() differs from it.
+ *
+ * Functions returning int report errors as -1 (handles as NULL), with the
+ * message in fmss_last_error() of the calling thread. No C++ exception
+ * crosses the interface. A scenario may be run from several threads at once
+ * as long as none of them modifies it.
+ */
+
+#ifndef FMSS_H
+#define FMSS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#  ifdef FMSS_BUILDING
+#    define FMSS_API __declspec(dllexport)
+#  else
+#    define FMSS_API __declspec(dllimport)
+#  endif
+#else
+#  define FMSS_API __attribute__((visibility("default")))
+#endif
+
+#define FMSS_ABI_VERSION 2
+
+typedef struct fmss_scenario fmss_scenario;
+typedef struct fmss_result fmss_result;
+
+/* Engines, as in SimulationEngine */
+enum {
+    FMSS_ENGINE_DAY_STEPPER = 0,
+    FMSS_ENGINE_EVENT_CALENDAR = 1
+};
+
+/* Swept settings, as in SweepParameter */
+enum {
+    FMSS_SWEEP_ADJUSTER_COUNT = 0,
+    FMSS_SWEEP_MACHINE_QUANTITY = 1,
+    FMSS_SWEEP_MTTF = 2,
+    FMSS_SWEEP_REPAIR_TIME = 3,
+    FMSS_SWEEP_SPARES = 4
+};
+
+typedef struct {
+    uint32_t struct_size;       /* sizeof(fmss_run_options), set by fmss_run_options_init */
+    int32_t days;
+    int32_t engine;             /* FMSS_ENGINE_* */
+    uint32_t seed;              /* seed of replication 0, replication r uses seed + r; 0 = random */
+    int32_t replications;
+    int32_t threads;            /* 0 = one per core */
+} fmss_run_options;
+
+/* Called after every finished replication, from the worker threads one at a
+ * time. Return nonzero to stop the run; it then fails with an error. */
+typedef int (*fmss_progress_fn)(int32_t done, int32_t total, void* user);
+
+typedef struct {
+    double mean;
+    double stdev;
+    double min;
+    double max;
+} fmss_metric;
+
+/* Over all replications of a run or sweep point */
+typedef struct {
+    int32_t replications;
+    fmss_metric machine_uptime;         /* percent */
+    fmss_metric adjuster_utilization;   /* percent */
+    fmss_metric repairs_completed;
+    fmss_metric max_queue_length;
+} fmss_summary;
+
+/* Per machine type of one replication, in the order the types were added */
+typedef struct {
+    int32_t quantity;
+    int32_t working;            /* on the last day */
+    int32_t broken;
+    int32_t spares_on_shelf;
+    int64_t failures;
+    int64_t spare_swaps;
+    double uptime;              /* percent */
+    double failures_per_machine;
+} fmss_machine_type_stats;
+
+/* Per adjuster group of one replication */
+typedef struct {
+    int32_t count;
+    int32_t busy;               /* on the last day */
+    int32_t call_ins;
+    int64_t busy_days;
+    int64_t available_days;
+    double utilization;         /* percent */
+    double cost;
+} fmss_adjuster_group_stats;
+
+/* Whole-plant figures of one replication */
+typedef struct {
+    uint32_t seed;
+    int32_t days;
+    int32_t max_queue_length;
+    int32_t preemptions;
+    int32_t max_lines_down;
+    int64_t failures;
+    int64_t repairs_completed;
+    int64_t plant_output;
+    int64_t plant_lost;
+    int64_t events;
+    uint64_t event_digest;
+    double machine_uptime;
+    double adjuster_utilization;
+    double contractor_cost;
+} fmss_replication_stats;
+
+FMSS_API int32_t fmss_abi_version(void);
+FMSS_API const char* fmss_last_error(void);
+
+/* ---- Scenarios ---- */
+
+FMSS_API fmss_scenario* fmss_scenario_new(void);
+FMSS_API void fmss_scenario_free(fmss_scenario* scenario);
+/* Replace the scenario with one in the scenario file format */
+FMSS_API int32_t fmss_scenario_parse(fmss_scenario* scenario, const char* text);
+/* Return the index of the new machine type or adjuster group */
+FMSS_API int32_t fmss_scenario_add_machine_type(fmss_scenario* scenario, const char* name,
+    int32_t mttf_days, int32_t repair_days, int32_t quantity);
+FMSS_API int32_t fmss_scenario_add_adjuster_group(fmss_scenario* scenario, const char* id, int32_t count,
+    const char* const* machine_types, int32_t machine_type_count);
+FMSS_API int32_t fmss_scenario_machine_type_count(const fmss_scenario* scenario);
+FMSS_API int32_t fmss_scenario_adjuster_group_count(const fmss_scenario* scenario);
+
+/* ---- Runs ---- */
+
+/* Set the defaults and struct_size; pass sizeof(fmss_run_options) */
+FMSS_API void fmss_run_options_init(fmss_run_options* options, uint32_t struct_size);
+
+/* Simulate every replication; NULL on error. progress may be NULL. */
+FMSS_API fmss_result* fmss_run(const fmss_scenario* scenario, const fmss_run_options* options,
+    fmss_progress_fn progress, void* user);
+
+/* Run the scenario once per value with one setting replaced (the index
+ * picks the machine type or adjuster group) and write one summary per
+ * value into `summaries`, which must hold value_count entries of
+ * summary_size bytes. */
+FMSS_API int32_t fmss_sweep(const fmss_scenario* scenario, int32_t parameter, int32_t index,
+    const int32_t* values, int32_t value_count, const fmss_run_options* options,
+    fmss_summary* summaries, uint32_t summary_size, fmss_progress_fn progress, void* user);
+
+/* ---- Results ---- */
+
+FMSS_API void fmss_result_free(fmss_result* result);
+FMSS_API int32_t fmss_result_summary(const fmss_result* result, fmss_summary* summary, uint32_t summary_size);
+/* Fill up to `capacity` entries of element_size bytes; return the number of
+ * entries there are */
+FMSS_API int32_t fmss_result_replications(const fmss_result* result,
+    fmss_replication_stats* out, uint32_t element_size, int32_t capacity);
+FMSS_API int32_t fmss_result_machine_types(const fmss_result* result, int32_t replication,
+    fmss_machine_type_stats* out, uint32_t element_size, int32_t capacity);
+FMSS_API int32_t fmss_result_adjuster_groups(const fmss_result* result, int32_t replication,
+    fmss_adjuster_group_stats* out, uint32_t element_size, int32_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,192 @@
+#include "Http.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+// ------------------- Parsing -------------------
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+string urlDecode(const string& text) {
+    string out;
+    out.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '+') out += ' ';
+        else if (text[i] == '%' && i + 2 < text.size() && hexValue(text[i + 1]) >= 0 && hexValue(text[i + 2]) >= 0) {
+            out += (char)(hexValue(text[i + 1]) * 16 + hexValue(text[i + 2]));
+            i += 2;
+        }
+        else out += text[i];
+    }
+    return out;
+}
+
+static string lowerCase(string s) {
+    for (char& c : s) c = (char)tolower((unsigned char)c);
+    return s;
+}
+
+static string trim(const string& s) {
+    size_t a = s.find_first_not_of(" \t"), b = s.find_last_not_of(" \t\r");
+    return a == string::npos ? string() : s.substr(a, b - a + 1);
+}
+
+bool HttpConnection::readRequest(HttpRequest& request, string& error) {
+    request = HttpRequest();
+    size_t header_end;
+    char chunk[16384];
+    while ((header_end = buffer.find("\r\n\r\n")) == string::npos) {
+        if (buffer.size() > MAX_HEADER_BYTES) {
+            error = "request header too large";
+            return false;
+        }
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            if (!buffer.empty()) error = "connection closed inside a request";
+            return false;
+        }
+        buffer.append(chunk, n);
+    }
+
+    // Request line and headers
+    size_t pos = 0;
+    bool first = true;
+    while (pos < header_end) {
+        size_t eol = buffer.find("\r\n", pos);
+        string line = buffer.substr(pos, eol - pos);
+        pos = eol + 2;
+        if (first) {
+            size_t a = line.find(' '), b = line.rfind(' ');
+            if (a == string::npos || b == a) {
+                error = "malformed request line";
+                return false;
+            }
+            request.method = line.substr(0, a);
+            string target = line.substr(a + 1, b - a - 1);
+            string version = line.substr(b + 1);
+            request.keep_alive = version != "HTTP/1.0";
+            size_t q = target.find('?');
+            request.path = urlDecode(target.substr(0, q));
+            if (q != string::npos) {
+                string params = target.substr(q + 1);
+                size_t start = 0;
+                while (start <= params.size()) {
+                    size_t amp = params.find('&', start);
+                    if (amp == string::npos) amp = params.size();
+                    string pair = params.substr(start, amp - start);
+                    size_t eq = pair.find('=');
+                    if (!pair.empty()) {
+                        request.query[urlDecode(pair.substr(0, eq))] = eq == string::npos ? string() : urlDecode(pair.substr(eq + 1));
+                    }
+                    start = amp + 1;
+                }
+            }
+            first = false;
+            continue;
+        }
+        size_t colon = line.find(':');
+        if (colon == string::npos) {
+            error = "malformed header line";
+            return false;
+        }
+        request.headers[lowerCase(trim(line.substr(0, colon)))] = trim(line.substr(colon + 1));
+    }
+    buffer.erase(0, header_end + 4);
+
+    auto connection = request.headers.find("connection");
+    if (connection != request.headers.end()) {
+        string value = lowerCase(connection->second);
+        if (value == "close") request.keep_alive = false;
+        else if (value == "keep-alive") request.keep_alive = true;
+    }
+    if (request.headers.count("transfer-encoding")) {
+        error = "chunked request bodies are not supported";
+        return false;
+    }
+
+    // Body
+    auto length = request.headers.find("content-length");
+    if (length != request.headers.end()) {
+        char* end;
+        unsigned long long n = strtoull(length->second.c_str(), &end, 10);
+        if (*end != '\0' || n > MAX_BODY_BYTES) {
+            error = "bad or too large Content-Length";
+            return false;
+        }
+        while (buffer.size() < n) {
+            ssize_t got = recv(fd, chunk, sizeof(chunk), 0);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) {
+                error = "connection closed inside a request body";
+                return false;
+            }
+            buffer.append(chunk, got);
+        }
+        request.body = buffer.substr(0, n);
+        buffer.erase(0, n);
+    }
+    keep_alive = request.keep_alive;
+    return true;
+}
+
+// ------------------- Responses -------------------
+
+const char* statusText(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 201: return "Created";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    case 422: return "Unprocessable Entity";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "Unknown";
+    }
+}
+
+bool HttpConnection::sendAll(const string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += n;
+    }
+    return true;
+}
+
+bool HttpConnection::sendResponse(int status, const string& content_type, const string& body) {
+    string head = "HTTP/1.1 " + to_string(status) + " " + statusText(status) + "\r\nContent-Type: " + content_type
+        + "\r\nContent-Length: " + to_string(body.size()) + (keep_alive ? "\r\n" : "\r\nConnection: close\r\n") + "\r\n";
+    return sendAll(head + body);
+}
+
+bool HttpConnection::startChunked(int status, const string& content_type) {
+    return sendAll("HTTP/1.1 " + to_string(status) + " " + statusText(status) + "\r\nContent-Type: " + content_type
+        + "\r\nTransfer-Encoding: chunked" + (keep_alive ? "\r\n" : "\r\nConnection: close\r\n") + "\r\n");
+}
+
+bool HttpConnection::sendChunk(const string& data) {
+    if (data.empty()) return true;      // an empty chunk would end the response
+    char size[20];
+    snprintf(size, sizeof(size), "%zx\r\n", data.size());
+    return sendAll(size + data + "\r\n");
+}
+
+bool HttpConnection::endChunked() {
+    return sendAll("0\r\n\r\n");
+}
@@ -0,0 +1,50 @@
+// Minimal HTTP/1.1 for the query server: one request at a time per
+// connection, keep-alive, Content-Length bodies in and chunked streaming out.
+// Works the same over TCP and Unix domain sockets.
+
+#pragma once
+
+#include <map>
+#include <string>
+
+struct HttpRequest {
+    std::string method;
+    std::string path;               // without the query string, percent-decoded
+    std::map<std::string, std::string> query; // decoded query parameters
+    std::map<std::string, std::string> headers; // names in lower case
+    std::string body;
+    bool keep_alive = true;
+    std::string peer;               // who is connected: "uid:N" on a Unix socket, "tcp" otherwise
+};
+
+class HttpConnection {
+private:
+    int fd;
+    std::string buffer;             // bytes read past the last request
+    bool keep_alive = true;         // of the request being answered
+
+    bool sendAll(const std::string& data);
+
+public:
+    static constexpr size_t MAX_HEADER_BYTES = 64 * 1024;
+    static constexpr size_t MAX_BODY_BYTES = 64 * 1024 * 1024;
+
+    explicit HttpConnection(int socket_fd) : fd(socket_fd) {}
+
+    // Next request; false at end of stream or on a malformed request (error
+    // set, the connection should then be closed after a 400)
+    bool readRequest(HttpRequest& request, std::string& error);
+
+    bool sendResponse(int status, const std::string& content_type, const std::string& body);
+    // Streamed response: headers now, then any number of chunks
+    bool startChunked(int status, const std::string& content_type);
+    bool sendChunk(const std::string& data);
+    bool endChunked();
+
+    bool keepAlive() const { return keep_alive; }
+    // Answer with Connection: close, for a response sent without reading a request
+    void closeAfterResponse() { keep_alive = false; }
+};
+
+std::string urlDecode(const std::string& text);
+const char* statusText(int status);
@@ -0,0 +1,164 @@
+#include "Metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Slots of the live threads, and the sums left by threads that have exited
+struct Registry {
+    mutex m;
+    vector<MetricSlot*> live;
+    MetricTotals retired;
+};
+
+// Never destroyed: threads may still exit while the process shuts down
+Registry& registry() {
+    static Registry* r = new Registry();
+    return *r;
+}
+
+void addSlot(MetricTotals& totals, const MetricSlot& slot) {
+    for (int c = 0; c < METRIC_COUNTER_COUNT; ++c) totals.counters[c] += slot.counters[c].load(memory_order_relaxed);
+    for (int l = 0; l < LATENCY_COUNT; ++l) {
+        for (int b = 0; b < LATENCY_BUCKETS; ++b) totals.buckets[l][b] += slot.buckets[l][b].load(memory_order_relaxed);
+        totals.latency_seconds[l] += slot.latency_ns[l].load(memory_order_relaxed) * 1e-9;
+    }
+}
+
+struct SlotOwner {
+    MetricSlot slot;
+    SlotOwner() {
+        Registry& r = registry();
+        lock_guard<mutex> lock(r.m);
+        r.live.push_back(&slot);
+    }
+    ~SlotOwner() {
+        Registry& r = registry();
+        lock_guard<mutex> lock(r.m);
+        addSlot(r.retired, slot);
+        for (size_t i = 0; i < r.live.size(); ++i) {
+            if (r.live[i] == &slot) {
+                r.live[i] = r.live.back();
+                r.live.pop_back();
+                break;
+            }
+        }
+    }
+};
+
+const char* const latency_names[LATENCY_COUNT] = { "analytic", "queue_wait", "replication", "job", "answer" };
+
+// Resident and virtual size from /proc; zero where it cannot be read
+void processMemory(double& resident, double& virtual_size) {
+    resident = virtual_size = 0.0;
+    ifstream statm("/proc/self/statm");
+    double pages_virtual, pages_resident;
+    if (statm >> pages_virtual >> pages_resident) {
+        double page = (double)sysconf(_SC_PAGESIZE);
+        virtual_size = pages_virtual * page;
+        resident = pages_resident * page;
+    }
+}
+
+string number(double v) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.10g", v);
+    return buf;
+}
+
+void family(ostringstream& out, const char* name, const char* type, const char* help) {
+    out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+}
+
+} // namespace
+
+MetricSlot& threadMetrics() {
+    thread_local SlotOwner owner;
+    return owner.slot;
+}
+
+void observeLatency(MetricLatency latency, double seconds) {
+    MetricSlot& slot = threadMetrics();
+    int b = 0;
+    while (b < LATENCY_BUCKETS - 1 && seconds > LATENCY_BOUNDS[b]) ++b;
+    bumpSlot(slot.buckets[latency][b], 1);
+    bumpSlot(slot.latency_ns[latency], (uint64_t)(max(seconds, 0.0) * 1e9));
+}
+
+MetricTotals metricTotals() {
+    Registry& r = registry();
+    lock_guard<mutex> lock(r.m);
+    MetricTotals totals = r.retired;
+    for (const MetricSlot* slot : r.live) addSlot(totals, *slot);
+    return totals;
+}
+
+string prometheusText(const ServiceGauges& gauges) {
+    MetricTotals t = metricTotals();
+    const uint64_t* c = t.counters;
+
+    ostringstream out;
+    family(out, "fmss_requests_total", "counter", "HTTP requests handled");
+    out << "fmss_requests_total " << c[METRIC_REQUESTS] << "\n";
+    family(out, "fmss_replications_completed_total", "counter", "Simulation replications completed");
+    out << "fmss_replications_completed_total " << c[METRIC_REPLICATIONS] << "\n";
+    family(out, "fmss_simulated_days_total", "counter", "Days simulated by the completed replications");
+    out << "fmss_simulated_days_total " << c[METRIC_SIMULATED_DAYS] << "\n";
+    family(out, "fmss_simulated_events_total", "counter",
+        "Failures, repairs and other discrete events of the completed replications, without the daily queue records");
+    out << "fmss_simulated_events_total " << c[METRIC_EVENTS] << "\n";
+
+    family(out, "fmss_jobs_total", "counter", "Simulation jobs finished, by outcome");
+    out << "fmss_jobs_total{outcome=\"completed\"} " << c[METRIC_JOBS_COMPLETED] << "\n"
+        << "fmss_jobs_total{outcome=\"cancelled\"} " << c[METRIC_JOBS_CANCELLED] << "\n";
+    family(out, "fmss_jobs_pending", "gauge", "Simulation jobs submitted and not yet over");
+    out << "fmss_jobs_pending " << gauges.pending_jobs << "\n";
+    family(out, "fmss_tasks", "gauge", "Replications waiting for or running on a worker");
+    out << "fmss_tasks{state=\"queued\"} " << gauges.queued_tasks << "\n"
+        << "fmss_tasks{state=\"running\"} " << gauges.running_tasks << "\n";
+    family(out, "fmss_workers", "gauge", "Simulation worker threads");
+    out << "fmss_workers " << gauges.workers << "\n";
+
+    family(out, "fmss_cache_requests_total", "counter", "Answer cache lookups, by cache and result");
+    out << "fmss_cache_requests_total{cache=\"analytic\",result=\"hit\"} " << c[METRIC_ANALYTIC_HITS] << "\n"
+        << "fmss_cache_requests_total{cache=\"analytic\",result=\"miss\"} " << c[METRIC_ANALYTIC_MISSES] << "\n"
+        << "fmss_cache_requests_total{cache=\"simulate\",result=\"hit\"} " << c[METRIC_RUN_HITS] << "\n"
+        << "fmss_cache_requests_total{cache=\"simulate\",result=\"miss\"} " << c[METRIC_RUN_MISSES] << "\n";
+    family(out, "fmss_cache_hit_ratio", "gauge", "Share of answer cache lookups that hit, since start");
+    uint64_t analytic = c[METRIC_ANALYTIC_HITS] + c[METRIC_ANALYTIC_MISSES], runs = c[METRIC_RUN_HITS] + c[METRIC_RUN_MISSES];
+    out << "fmss_cache_hit_ratio{cache=\"analytic\"} " << number(analytic ? (double)c[METRIC_ANALYTIC_HITS] / analytic : 0.0) << "\n"
+        << "fmss_cache_hit_ratio{cache=\"simulate\"} " << number(runs ? (double)c[METRIC_RUN_HITS] / runs : 0.0) << "\n";
+    family(out, "fmss_cache_entries", "gauge", "Answers held in each cache");
+    out << "fmss_cache_entries{cache=\"analytic\"} " << gauges.analytic_cached << "\n"
+        << "fmss_cache_entries{cache=\"simulate\"} " << gauges.runs_cached << "\n";
+    family(out, "fmss_scenarios", "gauge", "Scenarios uploaded");
+    out << "fmss_scenarios " << gauges.scenarios << "\n";
+
+    family(out, "fmss_phase_seconds", "histogram", "Latency of each request phase");
+    for (int l = 0; l < LATENCY_COUNT; ++l) {
+        uint64_t cumulative = 0;
+        for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+            cumulative += t.buckets[l][b];
+            out << "fmss_phase_seconds_bucket{phase=\"" << latency_names[l] << "\",le=\""
+                << (b < LATENCY_BUCKETS - 1 ? number(LATENCY_BOUNDS[b]) : "+Inf") << "\"} " << cumulative << "\n";
+        }
+        out << "fmss_phase_seconds_sum{phase=\"" << latency_names[l] << "\"} " << number(t.latency_seconds[l]) << "\n"
+            << "fmss_phase_seconds_count{phase=\"" << latency_names[l] << "\"} " << cumulative << "\n";
+    }
+
+    double resident, virtual_size;
+    processMemory(resident, virtual_size);
+    family(out, "process_resident_memory_bytes", "gauge", "Resident memory size in bytes");
+    out << "process_resident_memory_bytes " << number(resident) << "\n";
+    family(out, "process_virtual_memory_bytes", "gauge", "Virtual memory size in bytes");
+    out << "process_virtual_memory_bytes " << number(virtual_size) << "\n";
+    return out.str();
+}
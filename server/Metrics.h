@@ -0,0 +1,82 @@
+// Process-wide service metrics, exported in the Prometheus text format.
+//
+// Every thread that records something gets its own slot of counters and
+// latency histograms. Only that thread writes the slot, with relaxed atomic
+// stores, so recording costs no lock and no contended cache line; a scrape
+// sums the slots of the live threads plus what exited threads left behind.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+enum MetricCounter {
+    METRIC_REQUESTS,
+    METRIC_ANALYTIC_HITS,
+    METRIC_ANALYTIC_MISSES,
+    METRIC_RUN_HITS,
+    METRIC_RUN_MISSES,
+    METRIC_REPLICATIONS,        // completed, not cancelled
+    METRIC_EVENTS,              // discrete events (failures, repairs, ...) of the completed replications
+    METRIC_SIMULATED_DAYS,
+    METRIC_JOBS_COMPLETED,
+    METRIC_JOBS_CANCELLED,
+    METRIC_COUNTER_COUNT
+};
+
+// Request phases with a latency histogram
+enum MetricLatency {
+    LATENCY_ANALYTIC,           // computing an uncached analytic answer
+    LATENCY_QUEUE_WAIT,         // job submitted to its first replication starting
+    LATENCY_REPLICATION,        // worker time of one replication, its chunks summed
+    LATENCY_JOB,                // job submitted to its last replication finishing
+    LATENCY_ANSWER,             // summarizing a job's replications
+    LATENCY_COUNT
+};
+
+constexpr int LATENCY_BUCKETS = 8;      // upper bounds in seconds, then +Inf
+constexpr double LATENCY_BOUNDS[LATENCY_BUCKETS - 1] = { 0.0001, 0.001, 0.01, 0.1, 1.0, 10.0, 100.0 };
+
+struct MetricSlot {
+    std::atomic<uint64_t> counters[METRIC_COUNTER_COUNT] = {};
+    std::atomic<uint64_t> buckets[LATENCY_COUNT][LATENCY_BUCKETS] = {};
+    std::atomic<uint64_t> latency_ns[LATENCY_COUNT] = {};
+};
+
+// Called by the owning thread only
+inline void bumpSlot(std::atomic<uint64_t>& value, uint64_t n) {
+    value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+MetricSlot& threadMetrics();
+
+inline void countMetric(MetricCounter counter, uint64_t n = 1) {
+    bumpSlot(threadMetrics().counters[counter], n);
+}
+
+void observeLatency(MetricLatency latency, double seconds);
+
+// Current totals over every thread
+struct MetricTotals {
+    uint64_t counters[METRIC_COUNTER_COUNT] = {};
+    uint64_t buckets[LATENCY_COUNT][LATENCY_BUCKETS] = {};
+    double latency_seconds[LATENCY_COUNT] = {};
+};
+
+MetricTotals metricTotals();
+
+// Gauges the service knows at scrape time
+struct ServiceGauges {
+    int scenarios = 0;
+    size_t analytic_cached = 0;
+    size_t runs_cached = 0;
+    int pending_jobs = 0;
+    int queued_tasks = 0;
+    int running_tasks = 0;
+    int workers = 0;
+};
+
+// The whole /metrics page. Only reads the metrics, so any number of scrapers
+// can poll it; rates are left to the scraper (rate() over the _total counters).
+std::string prometheusText(const ServiceGauges& gauges);
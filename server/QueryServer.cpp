@@ -0,0 +1,202 @@
+// Long-lived what-if query server: keeps uploaded scenarios and their warm
+// analytic state in memory and answers queries over HTTP, on localhost or a
+// Unix domain socket. See WhatIfService.h for the queries.
+//
+// Build:  cmake --build build --target fmss_server
+// Run:    ./fmss_server [--port N | --socket PATH] [--days N] [--replications N] [--threads N]
+//                      [--max-connections N]
+//
+//   curl -X PUT --data-binary @factory.txt localhost:8750/scenarios/plant
+//   curl 'localhost:8750/scenarios/plant/analytic?group=electricians&add=1'
+//   curl -N 'localhost:8750/scenarios/plant/simulate?group=electricians&add=1&replications=20'
+//   curl -N -H 'x-tenant: alice' 'localhost:8750/scenarios/plant/sweep?group=electricians&adjusters=1,2,3,4'
+//   curl -X DELETE localhost:8750/jobs/7
+//   curl localhost:8750/metrics
+//   curl --unix-socket /tmp/fmss.sock http://localhost/health
+
+#include "Http.h"
+#include "WhatIfService.h"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+
+// Answers one request on the connection it came from
+class ConnectionResponder : public Responder {
+private:
+    HttpConnection& connection;
+    bool streaming = false;
+    bool failed = false;
+
+public:
+    explicit ConnectionResponder(HttpConnection& c) : connection(c) {}
+
+    void respond(int status, const string& json) override {
+        failed = !connection.sendResponse(status, "application/json", json);
+    }
+    void respondText(int status, const string& content_type, const string& body) override {
+        failed = !connection.sendResponse(status, content_type, body);
+    }
+    bool stream(const string& json_line) override {
+        if (failed) return false;
+        if (!streaming) {
+            streaming = true;
+            if (!connection.startChunked(200, "application/x-ndjson")) return !(failed = true);
+        }
+        failed = !connection.sendChunk(json_line + "\n");
+        return !failed;
+    }
+    void endStream() override {
+        if (!failed) failed = !connection.endChunked();
+    }
+    bool ok() const { return !failed; }
+};
+
+// The tenant a connection's simulations are charged to: the local user on a
+// Unix socket. TCP is loopback only and carries no identity beyond x-tenant.
+static string peerOf(int fd, bool unix_socket) {
+    if (!unix_socket) return "tcp";
+    ucred cred{};
+    socklen_t size = sizeof(cred);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &size) < 0) return "unix";
+    return "uid:" + to_string(cred.uid);
+}
+
+// Connections being served; at the limit new ones get a 503 straight away
+static atomic<int> open_connections{ 0 };
+
+static void serveConnection(int fd, bool unix_socket, WhatIfService& service) {
+    HttpConnection connection(fd);
+    string peer = peerOf(fd, unix_socket);
+    while (true) {
+        HttpRequest request;
+        string error;
+        if (!connection.readRequest(request, error)) {
+            if (!error.empty()) connection.sendResponse(400, "application/json", "{\"error\":" + jsonString(error) + "}");
+            break;
+        }
+        request.peer = peer;
+        ConnectionResponder out(connection);
+        service.handle(request, out);
+        if (!out.ok() || !connection.keepAlive()) break;
+    }
+    close(fd);
+    open_connections--;
+}
+
+// Sent from the accept loop without reading the request: a short response
+// fits the new socket's send buffer, so this does not block
+static void refuseConnection(int fd) {
+    HttpConnection connection(fd);
+    connection.closeAfterResponse();
+    connection.sendResponse(503, "application/json", "{\"error\":\"too many connections, try again later\"}");
+    close(fd);
+}
+
+static int listenTcp(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);     // local tools only
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 128) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int listenUnix(const string& path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path.c_str());
+    unlink(path.c_str());       // left over from an earlier run
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 128) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void usage(const char* prog) {
+    cerr << "usage: " << prog << " [options]\n"
+        << "  --port N                listen on 127.0.0.1:N (default 8750)\n"
+        << "  --socket PATH           listen on a Unix domain socket instead\n"
+        << "  --days N                simulated days per query (default 365)\n"
+        << "  --replications N        replications per query (default 10)\n"
+        << "  --threads N             simulation workers shared by all queries, 0 = one per core (default 0)\n"
+        << "  --max-connections N     connections served at once, more get a 503 (default 256)\n";
+}
+
+int main(int argc, char** argv) {
+    int port = 8750;
+    string socket_path;
+    ServiceOptions options;
+    int max_connections = 256;
+    bool ok = true;
+    for (int i = 1; i < argc && ok; ++i) {
+        int left = argc - i - 1;
+        if (!strcmp(argv[i], "--port") && left >= 1) port = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--socket") && left >= 1) socket_path = argv[++i];
+        else if (!strcmp(argv[i], "--days") && left >= 1) options.days = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--replications") && left >= 1) options.replications = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--threads") && left >= 1) options.threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--max-connections") && left >= 1) max_connections = atoi(argv[++i]);
+        else ok = false;
+    }
+    ok = ok && port > 0 && port < 65536 && options.days >= 1 && options.days <= options.max_days
+        && options.replications >= 1 && options.replications <= options.max_replications && options.threads >= 0
+        && max_connections >= 1;
+    if (!ok) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    int listen_fd = socket_path.empty() ? listenTcp(port) : listenUnix(socket_path);
+    if (listen_fd < 0) {
+        cerr << "cannot listen on " << (socket_path.empty() ? "127.0.0.1:" + to_string(port) : socket_path)
+            << ": " << strerror(errno) << "\n";
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    cerr << "fmss_server listening on " << (socket_path.empty() ? "http://127.0.0.1:" + to_string(port) : socket_path) << "\n";
+
+    WhatIfService service(options);
+    while (true) {
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            cerr << "accept failed: " << strerror(errno) << "\n";
+            return 1;
+        }
+        if (socket_path.empty()) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+        if (open_connections >= max_connections) {
+            refuseConnection(fd);
+            continue;
+        }
+        // Simulations run for seconds; each connection gets its own thread
+        // so they never hold up analytic answers. The thread only waits on
+        // the scheduler, whose workers do the simulating.
+        open_connections++;
+        thread(serveConnection, fd, !socket_path.empty(), ref(service)).detach();
+    }
+}
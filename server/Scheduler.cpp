@@ -0,0 +1,255 @@
+#include "Scheduler.h"
+
+using namespace std;
+
+const char* laneName(Lane lane) {
+    return lane == LANE_INTERACTIVE ? "interactive" : "batch";
+}
+
+FairScheduler::FairScheduler(int threads, double tenant_idle_seconds) : idle_seconds(tenant_idle_seconds) {
+    if (threads <= 0) threads = (int)max(1u, thread::hardware_concurrency());
+    for (int t = 0; t < threads; ++t) workers.emplace_back(&FairScheduler::workerLoop, this);
+}
+
+FairScheduler::~FairScheduler() {
+    {
+        lock_guard<mutex> lock(m);
+        stopping = true;
+        for (auto& it : jobs) it.second->cancelled = true;
+    }
+    work.notify_all();
+    progress.notify_all();
+    for (thread& t : workers) t.join();
+}
+
+string FairScheduler::peerOf(const string& tenant) {
+    return tenant.substr(0, tenant.find('/'));
+}
+
+// Under the lock
+FairScheduler::Tenant& FairScheduler::tenantNamed(const string& name) {
+    return peers[peerOf(name)].tenants[name];
+}
+
+// Under the lock. Forget tenants, and then peers, with nothing queued or
+// running for idle_seconds, so made-up tenant names do not pile up.
+void FairScheduler::pruneIdle(chrono::steady_clock::time_point now) {
+    for (auto p = peers.begin(); p != peers.end();) {
+        map<string, Tenant>& tenants = p->second.tenants;
+        for (auto t = tenants.begin(); t != tenants.end();) {
+            bool expired = t->second.idle()
+                && chrono::duration<double>(now - t->second.last_active).count() >= idle_seconds;
+            t = expired ? tenants.erase(t) : next(t);
+        }
+        p = tenants.empty() ? peers.erase(p) : next(p);
+    }
+}
+
+shared_ptr<Job> FairScheduler::submit(const string& tenant_name, Lane lane, int tasks, Job::TaskFn run) {
+    auto job = make_shared<Job>();
+    job->tenant = tenant_name;
+    job->lane = lane;
+    job->tasks = tasks;
+    job->run = move(run);
+    job->submitted = chrono::steady_clock::now();
+    {
+        lock_guard<mutex> lock(m);
+        job->id = next_id++;
+        pruneIdle(job->submitted);
+        Peer& peer = peers[peerOf(tenant_name)];
+        bool peer_idle = true;
+        for (const auto& it : peer.tenants) peer_idle = peer_idle && it.second.idle();
+        Tenant& tenant = peer.tenants[tenant_name];
+
+        // Coming back from idle: level with the least-served busy peer, and
+        // with the least-served busy tenant of the peer
+        if (peer_idle) {
+            double floor = -1.0;
+            for (const auto& it : peers) {
+                const Peer& other = it.second;
+                if (&other == &peer) continue;
+                bool busy = false;
+                for (const auto& t : other.tenants) busy = busy || !t.second.idle();
+                if (busy) floor = floor < 0 ? other.vtime : min(floor, other.vtime);
+            }
+            peer.vtime = max(peer.vtime, floor);
+        }
+        if (tenant.idle()) {
+            double floor = -1.0;
+            for (const auto& it : peer.tenants) {
+                const Tenant& other = it.second;
+                if (&other == &tenant || other.idle()) continue;
+                floor = floor < 0 ? other.vtime : min(floor, other.vtime);
+            }
+            tenant.vtime = max(tenant.vtime, floor);
+        }
+        tenant.last_active = job->submitted;
+        tenant.stats.jobs_submitted++;
+        if (tasks > 0) {
+            tenant.lanes[lane].push_back(job);
+            job->queued = true;
+            tenant.stats.queued_tasks += tasks;
+            jobs[job->id] = job;
+        }
+        else tenant.stats.jobs_completed++;
+    }
+    work.notify_all();
+    return job;
+}
+
+bool FairScheduler::cancel(uint64_t id, const string& tenant) {
+    {
+        lock_guard<mutex> lock(m);
+        auto it = jobs.find(id);
+        if (it == jobs.end() || (!tenant.empty() && it->second->tenant != tenant)) return false;
+        Job& job = *it->second;
+        if (job.cancelled.exchange(true)) return true;
+        // Queued tasks are dropped now; the deque entry goes at the next pick
+        Tenant& owner = tenantNamed(job.tenant);
+        owner.stats.queued_tasks -= job.tasks - job.next_task + (int)job.resumed.size();
+        owner.last_active = chrono::steady_clock::now();
+        if (job.running == 0) {
+            owner.stats.jobs_cancelled++;
+            jobs.erase(it);
+        }
+    }
+    progress.notify_all();
+    return true;
+}
+
+// Under the lock. Lane first, then the least-served peer with work in that
+// lane, then the least-served tenant of that peer.
+bool FairScheduler::pick(shared_ptr<Job>& job, int& task, Peer*& peer, Tenant*& tenant) {
+    for (int lane = LANE_INTERACTIVE; lane <= LANE_BATCH; ++lane) {
+        Peer* best_peer = nullptr;
+        Tenant* best = nullptr;
+        for (auto& p : peers) {
+            Tenant* first = nullptr;
+            for (auto& it : p.second.tenants) {
+                deque<shared_ptr<Job>>& queue = it.second.lanes[lane];
+                while (!queue.empty() && !queue.front()->hasWork()) {
+                    queue.front()->queued = false;
+                    queue.pop_front();
+                }
+                if (!queue.empty() && (!first || it.second.vtime < first->vtime)) first = &it.second;
+            }
+            if (first && (!best_peer || p.second.vtime < best_peer->vtime)) {
+                best_peer = &p.second;
+                best = first;
+            }
+        }
+        if (!best) continue;
+        job = best->lanes[lane].front();
+        if (!job->resumed.empty()) {
+            task = job->resumed.front();
+            job->resumed.pop_front();
+        }
+        else task = job->next_task++;
+        if (!job->hasWork()) {
+            job->queued = false;
+            best->lanes[lane].pop_front();
+        }
+        peer = best_peer;
+        tenant = best;
+        return true;
+    }
+    return false;
+}
+
+void FairScheduler::workerLoop() {
+    unique_lock<mutex> lock(m);
+    while (true) {
+        shared_ptr<Job> job;
+        int task;
+        Peer* peer;
+        Tenant* tenant;
+        if (!pick(job, task, peer, tenant)) {
+            if (stopping) return;
+            work.wait(lock);
+            continue;
+        }
+
+        // Charge an estimate now so the other workers see this tenant's
+        // share straight away; corrected when the task finishes
+        double estimate = job->runs > 0 ? job->task_seconds / job->runs : 0.001;
+        tenant->vtime += estimate;
+        peer->vtime += estimate;
+        tenant->stats.queued_tasks--;
+        tenant->stats.running_tasks++;
+        job->running++;
+        auto start = chrono::steady_clock::now();
+        if (!job->started) {
+            job->started = true;
+            tenant->stats.jobs_started++;
+            tenant->stats.first_task_wait_seconds += chrono::duration<double>(start - job->submitted).count();
+        }
+
+        lock.unlock();
+        bool more = !job->cancelled && job->run(task, job->cancelled);
+        auto end = chrono::steady_clock::now();
+        double seconds = chrono::duration<double>(end - start).count();
+        lock.lock();
+
+        tenant->vtime += seconds - estimate;
+        peer->vtime += seconds - estimate;
+        tenant->last_active = end;
+        tenant->stats.running_tasks--;
+        tenant->stats.worker_seconds += seconds;
+        job->running--;
+        job->runs++;
+        job->task_seconds += seconds;
+        if (job->cancelled) {
+            // A cancelled task is dropped, finished or not
+        }
+        else if (more) {
+            // Next chunk first in the job, the job first in its lane
+            job->resumed.push_back(task);
+            tenant->stats.queued_tasks++;
+            if (!job->queued) {
+                tenant->lanes[job->lane].push_front(job);
+                job->queued = true;
+            }
+        }
+        else {
+            job->done++;
+            tenant->stats.tasks_completed++;
+        }
+        if (job->over() && jobs.erase(job->id)) {
+            (job->cancelled ? tenant->stats.jobs_cancelled : tenant->stats.jobs_completed)++;
+        }
+        progress.notify_all();
+    }
+}
+
+int FairScheduler::waitProgress(Job& job, int seen, bool& over) {
+    unique_lock<mutex> lock(m);
+    progress.wait(lock, [&]() { return job.done > seen || job.over(); });
+    over = job.over();
+    return job.done;
+}
+
+void FairScheduler::wait(Job& job) {
+    unique_lock<mutex> lock(m);
+    progress.wait(lock, [&]() { return job.over(); });
+}
+
+map<string, TenantStats> FairScheduler::tenantStats() {
+    lock_guard<mutex> lock(m);
+    map<string, TenantStats> stats;
+    for (const auto& p : peers) {
+        for (const auto& it : p.second.tenants) stats[it.first] = it.second.stats;
+    }
+    return stats;
+}
+
+void FairScheduler::depth(int& pending_jobs, int& queued_tasks, int& running_tasks) {
+    lock_guard<mutex> lock(m);
+    pending_jobs = (int)jobs.size();
+    queued_tasks = running_tasks = 0;
+    for (const auto& p : peers) {
+        for (const auto& it : p.second.tenants) {
+            queued_tasks += it.second.stats.queued_tasks;
+            running_tasks += it.second.stats.running_tasks;
+        }
+    }
+}
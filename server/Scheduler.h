@@ -0,0 +1,134 @@
+// Shared worker pool for the query service. Jobs from many tenants are
+// split into tasks (one replication each). A tenant is named "PEER" or
+// "PEER/SUB": the peer is the connection's owner, and a sub-tenant is a
+// name the client picked. A free worker takes its next task as follows:
+//   - Lane: interactive before batch.
+//   - Peer: within a lane, the peer that has had the least worker time so
+//     far (start-time fair queuing).
+//   - Tenant: within the peer, the tenant that has had the least worker time.
+//   - Job: within the tenant, the oldest job.
+// A big sweep therefore shares the workers evenly with every other peer
+// and cannot hold up a quick query. Sub-tenants only split their peer's
+// share, so a client cannot get more by inventing tenant names. A peer or
+// tenant that goes idle and comes back starts level with the busy ones; it
+// does not bank the idle time. Tenants idle for idle_seconds are forgotten,
+// statistics included.
+//
+// A task may run in chunks: when it returns true it goes back to the front
+// of its job, and the next chunk is picked like any other task. A long
+// replication then holds a worker for one chunk at a time, so a new
+// interactive job waits for a chunk at most, not for a whole replication.
+//
+// Cancelling a job drops its queued tasks at once. Running tasks get the
+// job's cancel flag and are expected to check it (ReplicationRun does).
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum Lane {
+    LANE_INTERACTIVE,
+    LANE_BATCH
+};
+
+const char* laneName(Lane lane);
+
+struct Job {
+    // Returns true if the task has more to do and should be picked again
+    using TaskFn = std::function<bool(int task, const std::atomic<bool>& cancelled)>;
+
+    uint64_t id = 0;
+    std::string tenant;
+    Lane lane = LANE_BATCH;
+    int tasks = 0;
+    TaskFn run;
+    std::atomic<bool> cancelled{ false };
+
+    // Under the scheduler's lock
+    int next_task = 0;          // tasks below this have been handed out
+    std::deque<int> resumed;    // handed out, ran a chunk, and wait for the next
+    bool queued = false;        // in its tenant's lane
+    int running = 0;
+    int done = 0;
+    int runs = 0;               // task runs finished, chunks included
+    double task_seconds = 0.0;  // worker time of those runs
+    std::chrono::steady_clock::time_point submitted;
+    bool started = false;
+
+    bool over() const { return done == tasks || (cancelled && running == 0); }
+    bool hasWork() const { return !cancelled && (!resumed.empty() || next_task < tasks); }
+};
+
+struct TenantStats {
+    long long jobs_submitted = 0;
+    long long jobs_completed = 0;
+    long long jobs_cancelled = 0;
+    long long tasks_completed = 0;
+    double worker_seconds = 0.0;        // worker time spent on the tenant's tasks
+    double first_task_wait_seconds = 0.0;   // summed over jobs, submission to first task start
+    long long jobs_started = 0;
+    int queued_tasks = 0;
+    int running_tasks = 0;
+};
+
+class FairScheduler {
+private:
+    struct Tenant {
+        double vtime = 0.0;             // fair-queuing clock: worker seconds charged so far
+        std::deque<std::shared_ptr<Job>> lanes[2];
+        TenantStats stats;
+        std::chrono::steady_clock::time_point last_active;
+
+        bool idle() const { return lanes[0].empty() && lanes[1].empty() && stats.running_tasks == 0; }
+    };
+
+    struct Peer {
+        double vtime = 0.0;             // worker seconds charged to all its tenants
+        std::map<std::string, Tenant> tenants; // by full name
+    };
+
+    std::mutex m;
+    std::condition_variable work;       // a task was queued, or shutting down
+    std::condition_variable progress;   // a task finished
+    std::map<std::string, Peer> peers;
+    std::map<uint64_t, std::shared_ptr<Job>> jobs; // jobs not over yet, by id
+    uint64_t next_id = 1;
+    bool stopping = false;
+    double idle_seconds;
+    std::vector<std::thread> workers;
+
+    static std::string peerOf(const std::string& tenant);
+    Tenant& tenantNamed(const std::string& name);
+    void pruneIdle(std::chrono::steady_clock::time_point now);
+    bool pick(std::shared_ptr<Job>& job, int& task, Peer*& peer, Tenant*& tenant);
+    void workerLoop();
+
+public:
+    // threads 0 = one per core
+    explicit FairScheduler(int threads, double tenant_idle_seconds = 600.0);
+    ~FairScheduler();
+
+    std::shared_ptr<Job> submit(const std::string& tenant, Lane lane, int tasks, Job::TaskFn run);
+    // False if there is no such running job, or it belongs to another
+    // tenant (when `tenant` is given)
+    bool cancel(uint64_t id, const std::string& tenant = "");
+
+    // Block until more than `seen` tasks of the job are done or the job is
+    // over; returns the tasks done
+    int waitProgress(Job& job, int seen, bool& over);
+    void wait(Job& job);                   // until the job is over
+
+    std::map<std::string, TenantStats> tenantStats();
+    void depth(int& pending_jobs, int& queued_tasks, int& running_tasks);
+    int workerCount() const { return (int)workers.size(); }
+};
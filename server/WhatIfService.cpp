@@ -0,0 +1,735 @@
+#include "WhatIfService.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+using namespace std;
+
+// ------------------- JSON -------------------
+
+string jsonString(const string& s) {
+    string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        }
+        else if ((unsigned char)c < 0x20) {
+            char esc[8];
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            out += esc;
+        }
+        else out += c;
+    }
+    return out + "\"";
+}
+
+string jsonNumber(double v) {
+    if (!isfinite(v)) return "null";
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.10g", v);
+    return buf;
+}
+
+static string errorJson(const string& message) {
+    return "{\"error\":" + jsonString(message) + "}";
+}
+
+static string metricJson(const MetricSummary& m) {
+    return "{\"mean\":" + jsonNumber(m.mean) + ",\"stdev\":" + jsonNumber(m.stdev) + ",\"min\":" + jsonNumber(m.min)
+        + ",\"max\":" + jsonNumber(m.max) + "}";
+}
+
+static string summaryJson(const Results& r) {
+    return "{\"machine_uptime\":" + metricJson(r.machine_uptime) + ",\"adjuster_utilization\":" + metricJson(r.adjuster_utilization)
+        + ",\"repairs_completed\":" + metricJson(r.repairs_completed) + ",\"max_queue_length\":" + metricJson(r.max_queue_length) + "}";
+}
+
+// ------------------- Queueing model -------------------
+
+// Erlang C: probability that a failure waits for one of `servers` adjusters
+// at offered load `load` (in adjusters), for load < servers
+static double erlangC(int servers, double load) {
+    double b = 1.0;     // Erlang B, built up one server at a time
+    for (int k = 1; k <= servers; ++k) b = load * b / (k + load * b);
+    double rho = load / servers;
+    return b / (1.0 - rho * (1.0 - b));
+}
+
+// The setting a what-if changes, as it is in the scenario
+static int currentValue(const Scenario& s, SweepParameter parameter, int index) {
+    switch (parameter) {
+    case SWEEP_ADJUSTER_COUNT: return s.adjuster_groups[index].count;
+    case SWEEP_MACHINE_QUANTITY: return s.machine_types[index].quantity;
+    case SWEEP_MTTF: return s.machine_types[index].MTTF_days;
+    case SWEEP_REPAIR_TIME: return s.machine_types[index].repair_time;
+    case SWEEP_SPARES: return s.machine_types[index].spares;
+    }
+    return 0;
+}
+
+static void typeRates(const MachineType& mt, double& failures_per_day, double& repair_days) {
+    if (mt.failure_modes.empty()) {
+        failures_per_day = (double)mt.quantity / mt.MTTF_days;
+        repair_days = mt.repair_time;
+        return;
+    }
+    double rate = 0.0, work = 0.0;
+    for (const FailureMode& fm : mt.failure_modes) {
+        rate += 1.0 / fm.MTTF_days;
+        work += (double)fm.repair_time / fm.MTTF_days;
+    }
+    failures_per_day = mt.quantity * rate;
+    repair_days = work / rate;
+}
+
+// The failure stream is treated as Poisson (many machines, each up most of
+// the time) and repairs as exponential, so each group is an M/M/c queue.
+// Cheap enough to answer from the request thread.
+string WhatIfService::analyticAnswer(const Entry& entry, const Change& change) const {
+    const Scenario& s = entry.scenario;
+    vector<int> counts;
+    for (const AdjusterGroup& ag : s.adjuster_groups) counts.push_back(ag.count);
+    vector<double> failures = entry.type_failures_per_day, repair = entry.type_repair_days;
+    if (change.any) {
+        int i = change.sweep.index, v = change.sweep.values[0];
+        double old_value = currentValue(s, change.sweep.parameter, i);
+        switch (change.sweep.parameter) {
+        case SWEEP_ADJUSTER_COUNT: counts[i] = v; break;
+        case SWEEP_MACHINE_QUANTITY: failures[i] *= v / old_value; break;
+        case SWEEP_MTTF: failures[i] *= old_value / v; break;
+        case SWEEP_REPAIR_TIME: repair[i] *= v / old_value; break;
+        case SWEEP_SPARES: break;       // spares shorten downtime, not repair work
+        }
+    }
+
+    vector<GroupLoad> loads(counts.size());
+    for (size_t t = 0; t < failures.size(); ++t) {
+        const vector<int>& groups = entry.type_groups[t];
+        for (int g : groups) {
+            loads[g].failures_per_day += failures[t] / groups.size();
+            loads[g].work_per_day += failures[t] * repair[t] / groups.size();
+        }
+    }
+
+    ostringstream out;
+    out << "\"scenario\":" << jsonString(entry.name) << ",\"version\":" << entry.version
+        << ",\"change\":" << jsonString(change.describe) << ",\"model\":\"M/M/c per adjuster group\",\"groups\":[";
+    vector<double> wait(counts.size());
+    for (size_t g = 0; g < counts.size(); ++g) {
+        double load = loads[g].work_per_day, rho = load / counts[g];
+        double p_wait = 1.0;
+        wait[g] = numeric_limits<double>::infinity();
+        if (rho < 1.0) {
+            p_wait = load > 0 ? erlangC(counts[g], load) : 0.0;
+            double service = loads[g].failures_per_day > 0 ? load / loads[g].failures_per_day : 0.0;
+            wait[g] = p_wait * service / (counts[g] - load);
+        }
+        out << (g ? "," : "") << "{\"id\":" << jsonString(s.adjuster_groups[g].id) << ",\"adjusters\":" << counts[g]
+            << ",\"offered_load\":" << jsonNumber(load) << ",\"utilization\":" << jsonNumber(min(rho, 1.0))
+            << ",\"stable\":" << (rho < 1.0 ? "true" : "false") << ",\"p_wait\":" << jsonNumber(p_wait)
+            << ",\"mean_wait_days\":" << jsonNumber(wait[g]) << "}";
+    }
+    out << "],\"machine_types\":[";
+    double up = 0.0, total = 0.0;
+    for (size_t t = 0; t < failures.size(); ++t) {
+        const vector<int>& groups = entry.type_groups[t];
+        double w = 0.0;
+        for (int g : groups) w += wait[g] / groups.size();
+        int quantity = s.machine_types[t].quantity;
+        if (change.any && change.sweep.parameter == SWEEP_MACHINE_QUANTITY && change.sweep.index == (int)t) {
+            quantity = change.sweep.values[0];
+        }
+        // Fraction of time up: mean time to failure over the whole cycle
+        double per_machine = quantity > 0 ? failures[t] / quantity : 0.0;
+        double availability = per_machine > 0 ? 1.0 / (1.0 + per_machine * (repair[t] + w)) : 1.0;
+        if (!isfinite(w)) availability = 0.0;
+        up += availability * quantity;
+        total += quantity;
+        out << (t ? "," : "") << "{\"name\":" << jsonString(s.machine_types[t].name) << ",\"failures_per_day\":"
+            << jsonNumber(failures[t]) << ",\"mean_downtime_days\":" << jsonNumber(repair[t] + w)
+            << ",\"availability\":" << jsonNumber(availability) << "}";
+    }
+    out << "],\"availability\":" << jsonNumber(total > 0 ? up / total : 0.0) << "}";
+    return out.str();
+}
+
+// ------------------- Requests -------------------
+
+static bool validName(const string& name) {
+    if (name.empty() || name.size() > 64) return false;
+    for (char c : name) {
+        if (!isalnum((unsigned char)c) && c != '_' && c != '-' && c != '.') return false;
+    }
+    return true;
+}
+
+static bool parseInt(const string& text, int lo, int hi, int& value) {
+    if (text.empty()) return false;
+    char* end;
+    long v = strtol(text.c_str(), &end, 10);
+    if (*end != '\0' || v < lo || v > hi) return false;
+    value = (int)v;
+    return true;
+}
+
+void WhatIfService::handle(const HttpRequest& request, Responder& out) {
+    countMetric(METRIC_REQUESTS);
+    vector<string> parts;
+    size_t start = 1;
+    while (start <= request.path.size()) {
+        size_t slash = request.path.find('/', start);
+        if (slash == string::npos) slash = request.path.size();
+        if (slash > start) parts.push_back(request.path.substr(start, slash - start));
+        start = slash + 1;
+    }
+    const string& method = request.method;
+
+    try {
+        if (parts.size() == 1 && parts[0] == "health") {
+            out.respond(200, "{\"status\":\"ok\"}");
+        }
+        else if (parts.size() == 1 && parts[0] == "stats") {
+            stats(out);
+        }
+        else if (parts.size() == 1 && parts[0] == "metrics") {
+            metrics(out);
+        }
+        else if (parts.size() == 1 && parts[0] == "tenants") {
+            tenants(out);
+        }
+        else if (parts.size() == 2 && parts[0] == "jobs") {
+            if (method == "DELETE") cancelJob(parts[1], request, out);
+            else out.respond(405, errorJson("use DELETE"));
+        }
+        else if (parts.size() == 1 && parts[0] == "scenarios") {
+            if (method == "GET") listScenarios(out);
+            else out.respond(405, errorJson("use GET"));
+        }
+        else if (parts.size() >= 2 && parts[0] == "scenarios") {
+            const string& name = parts[1];
+            if (!validName(name)) {
+                out.respond(400, errorJson("scenario names use letters, digits, '_', '-' and '.'"));
+                return;
+            }
+            if (parts.size() == 2) {
+                if (method == "PUT") putScenario(name, request, out);
+                else if (method == "DELETE") deleteScenario(name, out);
+                else out.respond(405, errorJson("use PUT or DELETE"));
+                return;
+            }
+            shared_ptr<const Entry> entry = findScenario(name);
+            if (!entry) out.respond(404, errorJson("no scenario \"" + name + "\""));
+            else if (method != "GET") out.respond(405, errorJson("use GET"));
+            else if (parts.size() == 3 && parts[2] == "analytic") analytic(*entry, request, out);
+            else if (parts.size() == 3 && parts[2] == "simulate") simulate(*entry, request, out);
+            else if (parts.size() == 3 && parts[2] == "sweep") sweep(*entry, request, out);
+            else out.respond(404, errorJson("unknown query"));
+        }
+        else {
+            out.respond(404, errorJson("unknown path " + request.path));
+        }
+    }
+    catch (const exception& e) {
+        out.respond(500, errorJson(e.what()));
+    }
+}
+
+shared_ptr<const WhatIfService::Entry> WhatIfService::findScenario(const string& name) {
+    lock_guard<mutex> lock(cache_mutex);
+    auto it = scenarios.find(name);
+    return it == scenarios.end() ? nullptr : it->second;
+}
+
+void WhatIfService::putScenario(const string& name, const HttpRequest& request, Responder& out) {
+    auto entry = make_shared<Entry>();
+    entry->name = name;
+    istringstream text(request.body);
+    string error;
+    if (!parseScenario(text, entry->scenario, error) || !validateScenario(entry->scenario, error)) {
+        out.respond(422, errorJson(error));
+        return;
+    }
+
+    // Warm state: per-type rates and capable groups, so queries only redo
+    // the arithmetic for what changed
+    const Scenario& s = entry->scenario;
+    entry->type_groups.resize(s.machine_types.size());
+    for (size_t t = 0; t < s.machine_types.size(); ++t) {
+        double failures, repair;
+        typeRates(s.machine_types[t], failures, repair);
+        entry->type_failures_per_day.push_back(failures);
+        entry->type_repair_days.push_back(repair);
+    }
+    for (size_t g = 0; g < s.adjuster_groups.size(); ++g) {
+        for (const string& type : s.adjuster_groups[g].capable_machines) {
+            int t = s.machineTypeIndex(type);
+            if (t >= 0) entry->type_groups[t].push_back((int)g);
+        }
+    }
+
+    bool replaced;
+    {
+        lock_guard<mutex> lock(cache_mutex);
+        entry->version = next_version++;
+        replaced = scenarios.count(name) > 0;
+        scenarios[name] = entry;
+    }
+    out.respond(replaced ? 200 : 201, "{\"scenario\":" + jsonString(name) + ",\"version\":" + to_string(entry->version)
+        + ",\"machine_types\":" + to_string(s.machine_types.size()) + ",\"adjuster_groups\":" + to_string(s.adjuster_groups.size()) + "}");
+}
+
+void WhatIfService::listScenarios(Responder& out) {
+    lock_guard<mutex> lock(cache_mutex);
+    string json = "{\"scenarios\":[";
+    bool first = true;
+    for (const auto& it : scenarios) {
+        const Entry& e = *it.second;
+        json += (first ? "" : ",") + string("{\"name\":") + jsonString(e.name) + ",\"version\":" + to_string(e.version)
+            + ",\"machine_types\":" + to_string(e.scenario.machine_types.size())
+            + ",\"adjuster_groups\":" + to_string(e.scenario.adjuster_groups.size()) + "}";
+        first = false;
+    }
+    out.respond(200, json + "]}");
+}
+
+// Cached answers of the old version stay until the cache is next cleared;
+// their keys carry the version, so they are never served again
+void WhatIfService::deleteScenario(const string& name, Responder& out) {
+    lock_guard<mutex> lock(cache_mutex);
+    if (!scenarios.erase(name)) out.respond(404, errorJson("no scenario \"" + name + "\""));
+    else out.respond(200, "{\"deleted\":" + jsonString(name) + "}");
+}
+
+// One value, or with `list` a comma-separated list of them
+static bool parseValues(const string& text, int lo, int hi, bool list, size_t max_values, vector<int>& values) {
+    values.clear();
+    size_t start = 0;
+    while (true) {
+        size_t comma = list ? text.find(',', start) : string::npos;
+        int v;
+        if (!parseInt(text.substr(start, comma == string::npos ? string::npos : comma - start), lo, hi, v)) return false;
+        values.push_back(v);
+        if (comma == string::npos) break;
+        start = comma + 1;
+    }
+    return values.size() <= max_values;
+}
+
+static string joinValues(const vector<int>& values) {
+    string out;
+    for (size_t i = 0; i < values.size(); ++i) out += (i ? "," : "") + to_string(values[i]);
+    return out;
+}
+
+bool WhatIfService::parseChange(const Entry& entry, const HttpRequest& request, bool list, Change& change, string& error) const {
+    static const set<string> known = { "group", "adjusters", "add", "type", "quantity", "mttf", "repair", "spares",
+        "days", "replications", "seed", "lane" };
+    for (const auto& q : request.query) {
+        if (!known.count(q.first)) {
+            error = "unknown parameter \"" + q.first + "\"";
+            return false;
+        }
+    }
+    const Scenario& s = entry.scenario;
+    auto param = [&](const char* name) -> const string* {
+        auto it = request.query.find(name);
+        return it == request.query.end() ? nullptr : &it->second;
+    };
+    const string* group = param("group");
+    const string* type = param("type");
+    if (group && type) {
+        error = "change either a group or a machine type";
+        return false;
+    }
+    vector<int> values;
+    if (group) {
+        int g = s.adjusterGroupIndex(*group);
+        if (g < 0) {
+            error = "no adjuster group \"" + *group + "\"";
+            return false;
+        }
+        const string* adjusters = param("adjusters");
+        const string* add = param("add");
+        if ((adjusters != nullptr) == (add != nullptr)) {
+            error = "give adjusters=N or add=N with group";
+            return false;
+        }
+        if (adjusters ? !parseValues(*adjusters, 1, 100000, list, options.max_sweep_points, values)
+                : !parseValues(*add, -100000, 100000, list, options.max_sweep_points, values)) {
+            error = "adjuster count out of range";
+            return false;
+        }
+        for (int& value : values) {
+            if (add) value += s.adjuster_groups[g].count;
+            if (value < 1) {
+                error = "a group needs at least one adjuster";
+                return false;
+            }
+        }
+        change.sweep.parameter = SWEEP_ADJUSTER_COUNT;
+        change.sweep.index = g;
+        change.describe = "group " + *group + " adjusters ";
+    }
+    else if (type) {
+        int t = s.machineTypeIndex(*type);
+        if (t < 0) {
+            error = "no machine type \"" + *type + "\"";
+            return false;
+        }
+        static const pair<const char*, SweepParameter> settings[] = {
+            { "quantity", SWEEP_MACHINE_QUANTITY }, { "mttf", SWEEP_MTTF }, { "repair", SWEEP_REPAIR_TIME }, { "spares", SWEEP_SPARES }
+        };
+        int given = 0;
+        for (const auto& setting : settings) {
+            const string* v = param(setting.first);
+            if (!v) continue;
+            given++;
+            if (!parseValues(*v, setting.second == SWEEP_SPARES ? 0 : 1, 10000000, list, options.max_sweep_points, values)) {
+                error = string(setting.first) + " out of range";
+                return false;
+            }
+            change.sweep.parameter = setting.second;
+            change.describe = "type " + *type + " " + setting.first + " ";
+        }
+        if (given != 1) {
+            error = "give one of quantity, mttf, repair or spares with type";
+            return false;
+        }
+        change.sweep.index = t;
+    }
+    else if (param("adjusters") || param("add") || param("quantity") || param("mttf") || param("repair") || param("spares")) {
+        error = "say which group or type to change";
+        return false;
+    }
+    change.any = group || type;
+    change.sweep.values = values;
+    change.describe += joinValues(values);
+    return true;
+}
+
+void WhatIfService::applyChange(const Change& change, Scenario& scenario) {
+    if (!change.any) return;
+    int i = change.sweep.index, v = change.sweep.values[0];
+    switch (change.sweep.parameter) {
+    case SWEEP_ADJUSTER_COUNT: scenario.adjuster_groups[i].count = v; break;
+    case SWEEP_MACHINE_QUANTITY: scenario.machine_types[i].quantity = v; break;
+    case SWEEP_MTTF: scenario.machine_types[i].MTTF_days = v; break;
+    case SWEEP_REPAIR_TIME: scenario.machine_types[i].repair_time = v; break;
+    case SWEEP_SPARES: scenario.machine_types[i].spares = v; break;
+    }
+}
+
+void WhatIfService::analytic(const Entry& entry, const HttpRequest& request, Responder& out) {
+    Change change;
+    string error;
+    if (!parseChange(entry, request, false, change, error)) {
+        out.respond(400, errorJson(error));
+        return;
+    }
+    string key = entry.name + "#" + to_string(entry.version) + "|" + change.describe;
+    {
+        lock_guard<mutex> lock(cache_mutex);
+        auto it = analytic_cache.find(key);
+        if (it != analytic_cache.end()) {
+            countMetric(METRIC_ANALYTIC_HITS);
+            out.respond(200, "{\"cached\":true," + it->second);
+            return;
+        }
+    }
+    countMetric(METRIC_ANALYTIC_MISSES);
+    auto start = chrono::steady_clock::now();
+    string answer = analyticAnswer(entry, change);
+    observeLatency(LATENCY_ANALYTIC, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    {
+        lock_guard<mutex> lock(cache_mutex);
+        if (analytic_cache.size() >= options.max_cached_answers) analytic_cache.clear();
+        analytic_cache[key] = answer;
+    }
+    out.respond(200, "{\"cached\":false," + answer);
+}
+
+shared_ptr<const Results> WhatIfService::cachedRun(const string& key) {
+    lock_guard<mutex> lock(cache_mutex);
+    auto it = run_cache.find(key);
+    return it == run_cache.end() ? nullptr : it->second;
+}
+
+void WhatIfService::storeRun(const string& key, shared_ptr<const Results> results) {
+    lock_guard<mutex> lock(cache_mutex);
+    if (run_cache.size() >= options.max_cached_answers) run_cache.clear();
+    run_cache[key] = move(results);
+}
+
+bool WhatIfService::parseRunOptions(const HttpRequest& request, RunOptions& run, string& error) const {
+    run.days = options.days;
+    run.replications = options.replications;
+    run.seed = options.seed;
+    run.recent_events = 0;
+    auto it = request.query.find("days");
+    if (it != request.query.end() && !parseInt(it->second, 1, options.max_days, run.days)) {
+        error = "days must be between 1 and " + to_string(options.max_days);
+        return false;
+    }
+    it = request.query.find("replications");
+    if (it != request.query.end() && !parseInt(it->second, 1, options.max_replications, run.replications)) {
+        error = "replications must be between 1 and " + to_string(options.max_replications);
+        return false;
+    }
+    it = request.query.find("seed");
+    int seed;
+    if (it != request.query.end()) {
+        if (!parseInt(it->second, 1, numeric_limits<int>::max(), seed)) {
+            error = "seed must be a positive integer";
+            return false;
+        }
+        run.seed = (unsigned)seed;
+    }
+    it = request.query.find("lane");
+    if (it != request.query.end() && it->second != "batch" && it->second != "interactive") {
+        error = "lane is interactive or batch";
+        return false;
+    }
+    return true;
+}
+
+// x-tenant names a tenant within the connection's peer (a tool serving
+// several users); without it the peer itself is the tenant
+string WhatIfService::tenantOf(const HttpRequest& request) {
+    string peer = request.peer.empty() ? "local" : request.peer;
+    auto it = request.headers.find("x-tenant");
+    if (it != request.headers.end() && validName(it->second)) return peer + "/" + it->second;
+    return peer;
+}
+
+// Every replication of every point is one scheduler task, run in chunks of
+// chunk_days; the job's tasks all belong to the requesting tenant. Streams the job line and progress,
+// and on success leaves summarized results. On failure the stream has been
+// finished (or the client is gone) and false is returned.
+bool WhatIfService::runJob(const HttpRequest& request, const vector<Scenario>& points, const RunOptions& run,
+    vector<Results>& results, Responder& out) {
+    const int replications = run.replications;
+    results.assign(points.size(), Results());
+    double machine_days = 0.0;
+    for (size_t p = 0; p < points.size(); ++p) {
+        results[p].replications.resize(replications);
+        for (const MachineType& mt : points[p].machine_types) machine_days += (double)mt.quantity * run.days * replications;
+    }
+    // Small jobs go ahead of big ones; a client may demote itself, not promote
+    auto it = request.query.find("lane");
+    bool demoted = it != request.query.end() && it->second == "batch";
+    Lane lane = !demoted && machine_days <= options.interactive_machine_days ? LANE_INTERACTIVE : LANE_BATCH;
+
+    // A task is only ever on one worker at a time, so its slot in `runs`
+    // and `seconds` needs no lock. Metrics go to the worker's own slot.
+    int tasks = (int)points.size() * replications;
+    vector<unique_ptr<ReplicationRun>> runs(tasks);
+    vector<double> seconds(tasks, 0.0);
+    auto submitted = chrono::steady_clock::now();
+    shared_ptr<Job> job = scheduler.submit(tenantOf(request), lane, tasks,
+        [&](int task, const atomic<bool>& cancelled) {
+            int p = task / replications, r = task % replications;
+            auto start = chrono::steady_clock::now();
+            unique_ptr<ReplicationRun>& replication = runs[task];
+            if (!replication) {
+                if (task == 0) observeLatency(LATENCY_QUEUE_WAIT, chrono::duration<double>(start - submitted).count());
+                replication = make_unique<ReplicationRun>(points[p], run, run.seed + r);
+            }
+            bool stopped = !replication->advance(options.chunk_days, &cancelled);
+            seconds[task] += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (!stopped && !replication->finished()) return true;
+            if (!stopped) {
+                RunResult& result = results[p].replications[r];
+                replication->finish(result);
+                observeLatency(LATENCY_REPLICATION, seconds[task]);
+                countMetric(METRIC_REPLICATIONS);
+                countMetric(METRIC_EVENTS, (uint64_t)result.discrete_events);
+                countMetric(METRIC_SIMULATED_DAYS, (uint64_t)run.days);
+            }
+            replication.reset();
+            return false;
+        });
+    int total = tasks, done = 0;
+    bool over = false;
+    bool client_here = out.stream("{\"job\":" + to_string(job->id) + ",\"lane\":\"" + laneName(lane) + "\",\"tenant\":"
+        + jsonString(job->tenant) + "}");
+    while (client_here && !over) {
+        int now = scheduler.waitProgress(*job, done, over);
+        if (now > done) {
+            done = now;
+            client_here = out.stream("{\"progress\":" + to_string(done) + ",\"total\":" + to_string(total) + "}");
+        }
+    }
+    if (!client_here) {
+        // Nobody to answer: free the workers, and wait for the running
+        // tasks, which still write into `results`
+        scheduler.cancel(job->id);
+        scheduler.wait(*job);
+        countMetric(METRIC_JOBS_CANCELLED);
+        return false;
+    }
+    if (done < total) {
+        countMetric(METRIC_JOBS_CANCELLED);
+        if (out.stream(errorJson("job " + to_string(job->id) + " was cancelled"))) out.endStream();
+        return false;
+    }
+    auto finished = chrono::steady_clock::now();
+    observeLatency(LATENCY_JOB, chrono::duration<double>(finished - submitted).count());
+    countMetric(METRIC_JOBS_COMPLETED);
+    for (Results& r : results) summarizeResults(r);
+    observeLatency(LATENCY_ANSWER, chrono::duration<double>(chrono::steady_clock::now() - finished).count());
+    return true;
+}
+
+// The changed scenario runs with the baseline's seeds, so the difference
+// between them is not buried in replication noise. A baseline computed for
+// one what-if is reused by every other what-if with the same run options.
+void WhatIfService::simulate(const Entry& entry, const HttpRequest& request, Responder& out) {
+    Change change;
+    RunOptions run;
+    string error;
+    if (!parseChange(entry, request, false, change, error) || !parseRunOptions(request, run, error)) {
+        out.respond(400, errorJson(error));
+        return;
+    }
+    Scenario changed = entry.scenario;
+    applyChange(change, changed);
+    if (change.any && !validateScenario(changed, error)) {
+        out.respond(400, errorJson(error));
+        return;
+    }
+
+    string base_key = entry.name + "#" + to_string(entry.version) + "|" + to_string(run.days) + "|"
+        + to_string(run.replications) + "|" + to_string(run.seed) + "|";
+    string whatif_key = base_key + change.describe;
+    shared_ptr<const Results> baseline = cachedRun(base_key);
+    shared_ptr<const Results> whatif = change.any ? cachedRun(whatif_key) : baseline;
+    bool cached = baseline && whatif;
+    countMetric(cached ? METRIC_RUN_HITS : METRIC_RUN_MISSES);
+
+    if (!cached) {
+        // Both in one job when neither is cached: their replications share
+        // the workers
+        vector<Scenario> points;
+        if (!baseline) points.push_back(entry.scenario);
+        if (change.any && !whatif) points.push_back(changed);
+        vector<Results> results;
+        if (!runJob(request, points, run, results, out)) return;
+        for (Results& r : results) r.replications.clear();
+        size_t next = 0;
+        if (!baseline) baseline = make_shared<const Results>(move(results[next++]));
+        whatif = change.any ? make_shared<const Results>(move(results[next])) : baseline;
+        storeRun(base_key, baseline);
+        if (change.any) storeRun(whatif_key, whatif);
+    }
+
+    string answer = "{\"scenario\":" + jsonString(entry.name) + ",\"version\":" + to_string(entry.version)
+        + ",\"change\":" + jsonString(change.describe) + ",\"days\":" + to_string(run.days)
+        + ",\"replications\":" + to_string(run.replications) + ",\"seed\":" + to_string(run.seed)
+        + ",\"cached\":" + (cached ? "true" : "false") + ",\"baseline\":" + summaryJson(*baseline);
+    if (change.any) {
+        answer += ",\"whatif\":" + summaryJson(*whatif) + ",\"delta\":{\"machine_uptime\":"
+            + jsonNumber(whatif->machine_uptime.mean - baseline->machine_uptime.mean)
+            + ",\"adjuster_utilization\":" + jsonNumber(whatif->adjuster_utilization.mean - baseline->adjuster_utilization.mean)
+            + ",\"repairs_completed\":" + jsonNumber(whatif->repairs_completed.mean - baseline->repairs_completed.mean)
+            + ",\"max_queue_length\":" + jsonNumber(whatif->max_queue_length.mean - baseline->max_queue_length.mean) + "}";
+    }
+    if (out.stream(answer + "}")) out.endStream();
+}
+
+// One setting over a list of values, every point with the same seeds.
+// Sweeps are the big batch jobs, so they are not cached.
+void WhatIfService::sweep(const Entry& entry, const HttpRequest& request, Responder& out) {
+    Change change;
+    RunOptions run;
+    string error;
+    if (!parseChange(entry, request, true, change, error) || !parseRunOptions(request, run, error)) {
+        out.respond(400, errorJson(error));
+        return;
+    }
+    if (!change.any) {
+        out.respond(400, errorJson("say which group or type to sweep"));
+        return;
+    }
+    vector<Scenario> points;
+    for (int value : change.sweep.values) {
+        Change one = change;
+        one.sweep.values = { value };
+        points.push_back(entry.scenario);
+        applyChange(one, points.back());
+        if (!validateScenario(points.back(), error)) {
+            out.respond(400, errorJson("at " + to_string(value) + ": " + error));
+            return;
+        }
+    }
+    vector<Results> results;
+    if (!runJob(request, points, run, results, out)) return;
+
+    string answer = "{\"scenario\":" + jsonString(entry.name) + ",\"version\":" + to_string(entry.version)
+        + ",\"sweep\":" + jsonString(change.describe) + ",\"days\":" + to_string(run.days)
+        + ",\"replications\":" + to_string(run.replications) + ",\"seed\":" + to_string(run.seed) + ",\"points\":[";
+    for (size_t p = 0; p < points.size(); ++p) {
+        answer += (p ? "," : "") + string("{\"value\":") + to_string(change.sweep.values[p]) + ",\"summary\":"
+            + summaryJson(results[p]) + "}";
+    }
+    if (out.stream(answer + "]}")) out.endStream();
+}
+
+void WhatIfService::cancelJob(const string& id, const HttpRequest& request, Responder& out) {
+    int n;
+    if (!parseInt(id, 1, numeric_limits<int>::max(), n) || !scheduler.cancel((uint64_t)n, tenantOf(request))) {
+        out.respond(404, errorJson("no running job " + id + " of yours"));
+        return;
+    }
+    out.respond(200, "{\"cancelled\":" + id + "}");
+}
+
+void WhatIfService::tenants(Responder& out) {
+    string json = "{\"workers\":" + to_string(scheduler.workerCount()) + ",\"tenants\":[";
+    bool first = true;
+    for (const auto& it : scheduler.tenantStats()) {
+        const TenantStats& t = it.second;
+        json += (first ? "" : ",") + string("{\"tenant\":") + jsonString(it.first)
+            + ",\"jobs_submitted\":" + to_string(t.jobs_submitted) + ",\"jobs_completed\":" + to_string(t.jobs_completed)
+            + ",\"jobs_cancelled\":" + to_string(t.jobs_cancelled) + ",\"tasks_completed\":" + to_string(t.tasks_completed)
+            + ",\"queued_tasks\":" + to_string(t.queued_tasks) + ",\"running_tasks\":" + to_string(t.running_tasks)
+            + ",\"worker_seconds\":" + jsonNumber(t.worker_seconds)
+            + ",\"mean_start_wait_seconds\":" + jsonNumber(t.jobs_started ? t.first_task_wait_seconds / t.jobs_started : 0.0) + "}";
+        first = false;
+    }
+    out.respond(200, json + "]}");
+}
+
+void WhatIfService::stats(Responder& out) {
+    size_t scenario_count, analytic_size, run_size;
+    {
+        lock_guard<mutex> lock(cache_mutex);
+        scenario_count = scenarios.size();
+        analytic_size = analytic_cache.size();
+        run_size = run_cache.size();
+    }
+    int pending_jobs, queued_tasks, running_tasks;
+    scheduler.depth(pending_jobs, queued_tasks, running_tasks);
+    MetricTotals totals = metricTotals();
+    const uint64_t* c = totals.counters;
+    out.respond(200, "{\"requests\":" + to_string(c[METRIC_REQUESTS]) + ",\"scenarios\":" + to_string(scenario_count)
+        + ",\"analytic\":{\"hits\":" + to_string(c[METRIC_ANALYTIC_HITS]) + ",\"misses\":" + to_string(c[METRIC_ANALYTIC_MISSES])
+        + ",\"cached\":" + to_string(analytic_size) + "},\"simulate\":{\"hits\":" + to_string(c[METRIC_RUN_HITS])
+        + ",\"misses\":" + to_string(c[METRIC_RUN_MISSES]) + ",\"cached\":" + to_string(run_size) + "}"
+        + ",\"queued_tasks\":" + to_string(queued_tasks) + "}");
+}
+
+void WhatIfService::metrics(Responder& out) {
+    ServiceGauges gauges;
+    {
+        lock_guard<mutex> lock(cache_mutex);
+        gauges.scenarios = (int)scenarios.size();
+        gauges.analytic_cached = analytic_cache.size();
+        gauges.runs_cached = run_cache.size();
+    }
+    scheduler.depth(gauges.pending_jobs, gauges.queued_tasks, gauges.running_tasks);
+    gauges.workers = scheduler.workerCount();
+    out.respondText(200, "text/plain; version=0.0.4", prometheusText(gauges));
+}
@@ -0,0 +1,134 @@
+// What-if queries against cached scenarios, independent of the transport:
+// the server hands every parsed request to handle() together with a
+// Responder for the connection, and tests call it directly.
+//
+//   PUT    /scenarios/NAME              body: scenario file text
+//   GET    /scenarios                   list of cached scenarios
+//   DELETE /scenarios/NAME
+//   GET    /scenarios/NAME/analytic?CHANGE
+//   GET    /scenarios/NAME/simulate?CHANGE[&RUN]
+//   GET    /scenarios/NAME/sweep?CHANGE[&RUN]   CHANGE with a list, e.g. adjusters=1,2,4
+//   DELETE /jobs/ID                     cancel a running simulate or sweep
+//   GET    /tenants                     per-tenant scheduler statistics
+//   GET    /health, /stats
+//   GET    /metrics                     Prometheus text format, see Metrics.h
+//
+// RUN is days=N, replications=N, seed=N and lane=batch.
+// CHANGE is the what-if: group=ID with adjusters=N or add=N, or type=NAME
+// with one of quantity, mttf, repair or spares; no change asks about the
+// scenario as it is. Analytic answers come from a queueing model computed
+// when the scenario is uploaded; simulate answers run the baseline and the
+// changed scenario with the same seeds (common random numbers) and stream
+// progress as JSON lines. Both kinds of answer are cached per scenario
+// version and query.
+//
+// Simulations from every connection share one FairScheduler. The tenant is
+// the connection's peer, optionally narrowed by an x-tenant header; peers
+// get equal shares, and x-tenant names only split their peer's share. Jobs of
+// up to interactive_machine_days machine-days of simulation go in the
+// interactive lane; bigger ones, and any asked with lane=batch, in the batch
+// lane.
+
+#pragma once
+
+#include "Http.h"
+#include "Metrics.h"
+#include "Scheduler.h"
+#include "../Simulator.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+// Where handle() writes its answer. A request gets either one respond()
+// or a run of stream() calls closed by endStream().
+class Responder {
+public:
+    virtual ~Responder() = default;
+    virtual void respond(int status, const std::string& json) = 0;
+    virtual void respondText(int status, const std::string& content_type, const std::string& body) = 0;
+    // One JSON line of a streamed 200 response; false once the client is gone
+    virtual bool stream(const std::string& json_line) = 0;
+    virtual void endStream() = 0;
+};
+
+struct ServiceOptions {
+    int days = 365;                 // simulate defaults
+    int replications = 10;
+    unsigned seed = 1;
+    int threads = 0;                // scheduler workers, 0 = one per core
+    int max_replications = 1000;
+    int max_days = 36500;
+    size_t max_sweep_points = 100;
+    double interactive_machine_days = 5e7;  // biggest job the interactive lane takes
+    int chunk_days = 365;           // simulated days a replication runs before the scheduler picks again
+    size_t max_cached_answers = 10000;  // per kind; the cache is cleared when full
+    double tenant_idle_seconds = 600.0; // scheduler forgets tenants idle this long
+};
+
+class WhatIfService {
+private:
+    // Offered repair load on each adjuster group. Failures of a machine type
+    // are shared evenly between the groups that can repair it.
+    struct GroupLoad {
+        double failures_per_day = 0.0;
+        double work_per_day = 0.0;      // adjuster-days of repair work arriving per day
+    };
+
+    struct Entry {
+        std::string name;
+        uint64_t version;
+        Scenario scenario;
+        std::vector<double> type_failures_per_day; // per machine type, all machines
+        std::vector<double> type_repair_days;   // mean repair time per machine type
+        std::vector<std::vector<int>> type_groups; // capable adjuster groups per machine type
+    };
+
+    // A what-if parsed from the query parameters
+    struct Change {
+        bool any = false;
+        Sweep sweep;                // parameter, index and the new value (values for a sweep)
+        std::string describe;       // canonical form, part of cache keys
+    };
+
+    ServiceOptions options;
+    std::mutex cache_mutex;
+    std::map<std::string, std::shared_ptr<const Entry>> scenarios;
+    std::map<std::string, std::string> analytic_cache;  // key -> JSON answer
+    std::map<std::string, std::shared_ptr<const Results>> run_cache; // key -> simulated results
+    uint64_t next_version = 1;
+    FairScheduler scheduler;
+
+    std::shared_ptr<const Entry> findScenario(const std::string& name);
+    bool parseChange(const Entry& entry, const HttpRequest& request, bool list, Change& change, std::string& error) const;
+    bool parseRunOptions(const HttpRequest& request, RunOptions& run, std::string& error) const;
+    static std::string tenantOf(const HttpRequest& request);
+    bool runJob(const HttpRequest& request, const std::vector<Scenario>& points, const RunOptions& run,
+        std::vector<Results>& results, Responder& out);
+    static void applyChange(const Change& change, Scenario& scenario);
+
+    void putScenario(const std::string& name, const HttpRequest& request, Responder& out);
+    void listScenarios(Responder& out);
+    void deleteScenario(const std::string& name, Responder& out);
+    void analytic(const Entry& entry, const HttpRequest& request, Responder& out);
+    void simulate(const Entry& entry, const HttpRequest& request, Responder& out);
+    void sweep(const Entry& entry, const HttpRequest& request, Responder& out);
+    void cancelJob(const std::string& id, const HttpRequest& request, Responder& out);
+    void tenants(Responder& out);
+    void stats(Responder& out);
+    void metrics(Responder& out);
+
+    std::string analyticAnswer(const Entry& entry, const Change& change) const;
+    std::shared_ptr<const Results> cachedRun(const std::string& key);
+    void storeRun(const std::string& key, std::shared_ptr<const Results> results);
+
+public:
+    explicit WhatIfService(const ServiceOptions& service_options = ServiceOptions())
+        : options(service_options), scheduler(service_options.threads, service_options.tenant_idle_seconds) {}
+
+    void handle(const HttpRequest& request, Responder& out);
+};
+
+// JSON helpers
+std::string jsonString(const std::string& s);
+std::string jsonNumber(double v);
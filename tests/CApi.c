@@ -0,0 +1,150 @@
+/* C interface tests: builds a scenario through libfmss from plain C, runs and
+ * sweeps it, and checks the results against the interface's promises
+ * (caller-owned buffers, struct sizes, repeatable seeds, progress, stopping,
+ * errors).
+ *
+ * Build:  cmake --build build --target fmss_capi_test
+ * Run:    ./fmss_capi_test
+ */
+
+#include "../capi/fmss.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+static int failures = 0;
+
+static void check(int ok, const char* what) {
+    printf("%s  %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok) {
+        printf("      last error: %s\n", fmss_last_error());
+        failures++;
+    }
+}
+
+struct Progress {
+    int calls;
+    int last_done;
+    int total;
+    int stop_after;     /* 0 = never stop */
+};
+
+static int onProgress(int32_t done, int32_t total, void* user) {
+    struct Progress* p = (struct Progress*)user;
+    p->calls++;
+    p->last_done = done;
+    p->total = total;
+    return p->stop_after > 0 && done >= p->stop_after;
+}
+
+int main(void) {
+    check(fmss_abi_version() == FMSS_ABI_VERSION, "ABI version matches the header");
+
+    fmss_scenario* scenario = fmss_scenario_new();
+    const char* mechanics[] = { "lathe", "press" };
+    check(fmss_scenario_add_machine_type(scenario, "lathe", 120, 3, 40) == 0, "add machine type");
+    check(fmss_scenario_add_machine_type(scenario, "press", 200, 5, 10) == 1, "add second machine type");
+    check(fmss_scenario_add_machine_type(scenario, "press", 200, 5, 10) == -1 && strlen(fmss_last_error()) > 0,
+        "duplicate machine type is an error");
+    check(fmss_scenario_add_adjuster_group(scenario, "mechanics", 2, mechanics, 2) == 0, "add adjuster group");
+    const char* unknown[] = { "drill" };
+    check(fmss_scenario_add_adjuster_group(scenario, "drillers", 1, unknown, 1) == -1, "unknown machine type is an error");
+
+    fmss_run_options options;
+    fmss_run_options_init(&options, sizeof options);
+    options.days = 730;
+    options.seed = 42;
+    options.replications = 8;
+    options.threads = 4;
+
+    struct Progress progress = { 0, 0, 0, 0 };
+    fmss_result* result = fmss_run(scenario, &options, onProgress, &progress);
+    check(result != NULL, "run");
+    check(progress.calls == 8 && progress.last_done == 8 && progress.total == 8, "progress after every replication");
+
+    fmss_replication_stats runs[8];
+    check(fmss_result_replications(result, NULL, sizeof *runs, 0) == 8, "replication count from an empty buffer");
+    check(fmss_result_replications(result, runs, sizeof *runs, 8) == 8 && runs[3].seed == 45 && runs[3].days == 730,
+        "replication r is seeded with seed + r");
+
+    fmss_machine_type_stats types[2];
+    check(fmss_result_machine_types(result, 0, types, sizeof *types, 2) == 2 && types[0].quantity == 40 && types[1].quantity == 10,
+        "machine type results in scenario order");
+    fmss_adjuster_group_stats groups[1];
+    check(fmss_result_adjuster_groups(result, 0, groups, sizeof *groups, 1) == 1 && groups[0].count == 2, "adjuster group results");
+    check(fmss_result_machine_types(result, 8, types, sizeof *types, 2) == -1, "replication out of range is an error");
+
+    fmss_summary summary;
+    fmss_result_summary(result, &summary, sizeof summary);
+    check(summary.replications == 8 && summary.machine_uptime.min <= summary.machine_uptime.mean
+        && summary.machine_uptime.mean <= summary.machine_uptime.max, "summary over replications");
+
+    /* A caller built against an older, shorter struct: only its leading
+     * fields are written, entries are spaced by its size, and the bytes
+     * past the buffer stay untouched */
+    const uint32_t old_size = offsetof(fmss_replication_stats, failures);
+    unsigned char old_runs[2 * sizeof(fmss_replication_stats)];
+    memset(old_runs, 0xAB, sizeof old_runs);
+    fmss_replication_stats second;
+    check(fmss_result_replications(result, (fmss_replication_stats*)old_runs, old_size, 2) == 8, "shorter result struct");
+    memcpy(&second, old_runs + old_size, old_size);
+    int untouched = 1;
+    for (size_t b = 2 * old_size; b < sizeof old_runs; ++b) untouched = untouched && old_runs[b] == 0xAB;
+    check(second.seed == 43 && second.days == 730 && untouched, "shorter result struct is not overrun");
+    check(fmss_result_replications(result, runs, 0, 8) == -1, "zero element size is an error");
+
+    /* Options from an older header without `threads`: it takes its default */
+    fmss_run_options old_options = options;
+    old_options.struct_size = offsetof(fmss_run_options, threads);
+    old_options.threads = -1;
+    old_options.replications = 2;
+    fmss_result* old_result = fmss_run(scenario, &old_options, NULL, NULL);
+    check(old_result != NULL && fmss_result_replications(old_result, NULL, sizeof *runs, 0) == 2,
+        "shorter options struct uses the defaults for what it lacks");
+    fmss_result_free(old_result);
+    old_options.struct_size = 0;
+    check(fmss_run(scenario, &old_options, NULL, NULL) == NULL, "options without a size are an error");
+
+    /* Same seed on one thread: identical event sequences */
+    options.threads = 1;
+    fmss_result* again = fmss_run(scenario, &options, NULL, NULL);
+    fmss_replication_stats runs_again[8];
+    fmss_result_replications(again, runs_again, sizeof *runs_again, 8);
+    int same = 1;
+    for (int r = 0; r < 8; ++r) same = same && runs[r].event_digest == runs_again[r].event_digest;
+    check(same, "results do not depend on the thread count");
+    fmss_result_free(again);
+    fmss_result_free(result);
+
+    /* Stopping from the progress callback */
+    struct Progress stopping = { 0, 0, 0, 2 };
+    options.threads = 2;
+    check(fmss_run(scenario, &options, onProgress, &stopping) == NULL && stopping.calls == 2,
+        "progress callback stops the run");
+
+    /* Sweep over the number of mechanics: more adjusters, shorter queues */
+    int32_t counts[] = { 1, 2, 4 };
+    fmss_summary points[3];
+    struct Progress sweep_progress = { 0, 0, 0, 0 };
+    options.threads = 0;
+    check(fmss_sweep(scenario, FMSS_SWEEP_ADJUSTER_COUNT, 0, counts, 3, &options, points, sizeof *points,
+        onProgress, &sweep_progress) == 0, "sweep");
+    check(sweep_progress.total == 24 && sweep_progress.last_done == 24, "sweep progress counts every replication");
+    check(points[0].max_queue_length.mean >= points[2].max_queue_length.mean, "queue shrinks with more adjusters");
+    int32_t bad[] = { 0 };
+    check(fmss_sweep(scenario, FMSS_SWEEP_ADJUSTER_COUNT, 0, bad, 1, &options, points, sizeof *points, NULL, NULL) == -1,
+        "invalid sweep value is an error");
+
+    /* Scenario file text */
+    fmss_scenario* parsed = fmss_scenario_new();
+    check(fmss_scenario_parse(parsed, "machine_type lathe 120 3 40\nadjuster_group mechanics 4 lathe\n") == 0
+        && fmss_scenario_machine_type_count(parsed) == 1 && fmss_scenario_adjuster_group_count(parsed) == 1,
+        "parse scenario text");
+    check(fmss_scenario_parse(parsed, "machine_type lathe\n") == -1, "malformed scenario text is an error");
+    fmss_scenario_free(parsed);
+    fmss_scenario_free(scenario);
+
+    printf("\n%d failure(s)\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,297 @@
+// Differential tests: candidate engines against the reference day stepper.
+//
+// Build:  cmake --build build --target fmss_differential
+// Run:    ./fmss_differential [--quick]
+//
+// Every candidate is run on generated factories with each simulator feature
+// switched on in turn. Candidates that promise identical results (same
+// seed, same random draws in the same order) are stepped day by day next to
+// the reference and must log the same event sequence, compared through the
+// event digest. Every candidate must also pass a statistical check: over
+// independent replications, mean failures, completed repairs and peak queue
+// length may not differ from the reference by more than a Welch t bound.
+// Finally, runScenario on several threads with chunked replications must
+// log the same events per replication as one thread running them whole.
+// Exits non-zero on any failure.
+
+#include "../Simulator.h"
+#include "../tools/ScenarioGenerator.h"
+
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+struct Candidate {
+    string name;
+    SimulationEngine engine;
+    bool exact;         // must reproduce the reference event sequence
+};
+
+const vector<Candidate> candidates = {
+    { "event-calendar", ENGINE_EVENT_CALENDAR, true },
+};
+
+// ------------------- Scenarios -------------------
+
+struct Variant {
+    string name;
+    function<void(Scenario&, const GeneratorOptions&)> apply;
+};
+
+vector<Variant> variants() {
+    return {
+        { "base", [](Scenario&, const GeneratorOptions&) {} },
+        { "priorities", [](Scenario& scenario, const GeneratorOptions& f) {
+            for (int t = 0; t < f.types; t += 2) scenario.machine_types[t].priority = 1 + t % 3;
+        } },
+        { "teams", [](Scenario& scenario, const GeneratorOptions& f) {
+            for (int t = 0; t < f.types; t += 2) {
+                scenario.machine_types[t].max_crew = 3;
+                scenario.machine_types[t].crew_speedup = { 1.6, 2.0 };
+            }
+        } },
+        { "ageing", [](Scenario& scenario, const GeneratorOptions& f) {
+            for (int t = 0; t < f.types; ++t) {
+                MachineType& mt = scenario.machine_types[t];
+                mt.ageing_model = t % 3 == 0 ? AGEING_KIJIMA_I : t % 3 == 1 ? AGEING_KIJIMA_II : AGEING_HAZARD_MULTIPLIER;
+                mt.weibull_shape = 2.0;
+                mt.repair_effect = mt.ageing_model == AGEING_HAZARD_MULTIPLIER ? 1.05 : 0.5;
+            }
+        } },
+        { "season", [](Scenario& scenario, const GeneratorOptions& f) {
+            for (int t = 0; t < f.types; t += 2) {
+                scenario.machine_types[t].season.days = { 90, 90, 185 };
+                scenario.machine_types[t].season.factor = { 1.0, 2.5, 0.7 };
+            }
+        } },
+        { "failure-modes", [](Scenario& scenario, const GeneratorOptions& f) {
+            for (int t = 0; t < f.types; t += 2) {
+                MachineType& mt = scenario.machine_types[t];
+                mt.failure_modes = { FailureMode("wear", mt.MTTF_days * 2, mt.repair_time, ""),
+                    FailureMode("electrical", mt.MTTF_days * 3, mt.repair_time * 2, "electrical") };
+            }
+            scenario.adjuster_groups[0].skills = { "electrical" };
+        } },
+        { "spares", [](Scenario& scenario, const GeneratorOptions& f) {
+            for (int t = 0; t < f.types; ++t) {
+                scenario.machine_types[t].spares = 2;
+                scenario.machine_types[t].switchover_days = t % 2;
+            }
+        } },
+        { "shocks-cascades", [](Scenario& scenario, const GeneratorOptions& f) {
+            scenario.addShockRule(ShockRule("power", 60.0, 0.2, { "type0", "type1" }));
+            for (int t = 1; t < f.types; ++t) {
+                scenario.addCascadeRule(CascadeRule("type" + to_string(t - 1), "type" + to_string(t), 3.0, 10));
+            }
+        } },
+        // Walks of over a day, with preemption and team repairs on top
+        { "zones", [](Scenario& scenario, const GeneratorOptions& f) {
+            scenario.addZone("hall A");
+            scenario.addZone("hall B", { 6.0 });
+            scenario.addZone("yard", { 12.0, 9.0 });
+            for (int t = 0; t < f.types; ++t) {
+                MachineType& mt = scenario.machine_types[t];
+                mt.machine_zones.resize(mt.quantity);
+                for (int q = 0; q < mt.quantity; ++q) mt.machine_zones[q] = (q + t) % 3;
+                if (t % 2 == 0) mt.priority = 1 + t % 3;
+                else if (t % 4 == 1) {
+                    mt.max_crew = 3;
+                    mt.crew_speedup = { 1.6, 2.0 };
+                }
+            }
+            for (int g = 0; g < f.groups; ++g) scenario.adjuster_groups[g].home_zone = g % 3;
+        } },
+        { "on-call", [](Scenario& scenario, const GeneratorOptions& f) {
+            AdjusterGroup& ag = scenario.adjuster_groups[f.groups - 1];
+            ag.on_call = true;
+            ag.call_in_queue = 5;
+            ag.call_in_days = 3;
+            ag.release_queue = 1;
+            ag.release_days = 5;
+        } },
+    };
+}
+
+vector<GeneratorOptions> factories(bool quick) {
+    vector<GeneratorOptions> list;
+    OverlapPattern patterns[] = { OVERLAP_DISJOINT, OVERLAP_NESTED, OVERLAP_RANDOM };
+    for (int p = 0; p < 3; ++p) {
+        GeneratorOptions f;
+        f.seed = 100 + p;
+        f.types = 8;
+        f.machines = quick ? 200 : 1000;
+        f.groups = 3;
+        f.adjusters = quick ? 6 : 25;
+        f.overlap = patterns[p];
+        list.push_back(f);
+    }
+    return list;
+}
+
+Scenario buildScenario(const GeneratorOptions& f, const Variant& v) {
+    stringstream text;
+    generateScenario(text, f);
+    Scenario scenario;
+    string error;
+    if (!parseScenario(text, scenario, error)) throw runtime_error("generated scenario rejected: " + error);
+    v.apply(scenario, f);
+    return scenario;
+}
+
+void buildSimulator(FMSSimulator& sim, const GeneratorOptions& f, const Variant& v, SimulationEngine engine, unsigned seed) {
+    sim.setScenario(buildScenario(f, v));
+    sim.setEngine(engine);
+    sim.setSeed(seed);
+}
+
+// ------------------- Checks -------------------
+
+// Step both engines day by day; returns the first day the event digests
+// differ, or 0 if the runs match
+int firstDivergence(const GeneratorOptions& f, const Variant& v, const Candidate& c, int days, unsigned seed) {
+    FMSSimulator reference, candidate;
+    buildSimulator(reference, f, v, ENGINE_DAY_STEPPER, seed);
+    buildSimulator(candidate, f, v, c.engine, seed);
+
+    reference.startSimulation(days);
+    candidate.startSimulation(days);
+    int diverged = 0;
+    for (int day = 1; day <= days && !diverged; ++day) {
+        reference.simulateDay(day);
+        candidate.simulateDay(day);
+        if (reference.eventDigest() != candidate.eventDigest() || reference.eventCount() != candidate.eventCount()) {
+            diverged = day;
+        }
+    }
+    reference.finishSimulation();
+    candidate.finishSimulation();
+    if (!diverged && (reference.failureCount() != candidate.failureCount() || reference.repairCount() != candidate.repairCount()
+        || reference.preemptionCount() != candidate.preemptionCount())) {
+        diverged = days;
+    }
+    return diverged;
+}
+
+struct Sample {
+    double sum = 0.0, sum_sq = 0.0;
+    int n = 0;
+
+    void add(double x) {
+        sum += x;
+        sum_sq += x * x;
+        n++;
+    }
+    double mean() const { return sum / n; }
+    double variance() const { return n > 1 ? max(0.0, (sum_sq - sum * sum / n) / (n - 1)) : 0.0; }
+};
+
+// Welch's t statistic for the difference of two means
+double welchT(const Sample& a, const Sample& b) {
+    double se = sqrt(a.variance() / a.n + b.variance() / b.n);
+    if (se == 0.0) return a.mean() == b.mean() ? 0.0 : numeric_limits<double>::infinity();
+    return (a.mean() - b.mean()) / se;
+}
+
+// Largest |t| over the compared metrics, with independent seeds per engine
+double statisticalDistance(const GeneratorOptions& f, const Variant& v, const Candidate& c, int days, int replications) {
+    const int metrics = 3;
+    Sample ref[metrics], cand[metrics];
+    for (int r = 0; r < replications; ++r) {
+        for (int side = 0; side < 2; ++side) {
+            FMSSimulator sim;
+            buildSimulator(sim, f, v, side == 0 ? ENGINE_DAY_STEPPER : c.engine, side == 0 ? 1000 + r : 5000 + r);
+            sim.simulate(days);
+            Sample* s = side == 0 ? ref : cand;
+            s[0].add((double)sim.failureCount());
+            s[1].add((double)sim.repairCount());
+            s[2].add((double)sim.maxQueueLength());
+        }
+    }
+    double worst = 0.0;
+    for (int k = 0; k < metrics; ++k) worst = max(worst, fabs(welchT(ref[k], cand[k])));
+    return worst;
+}
+
+// Replications whose events differ between one thread running them whole
+// and the work-stealing pool running them in chunks
+int schedulingMismatches(const GeneratorOptions& f, const Variant& v, int days, int replications) {
+    Scenario scenario = buildScenario(f, v);
+    RunOptions options;
+    options.days = days;
+    options.replications = replications;
+    options.seed = 31;
+    options.recent_events = 0;
+    Results whole, chunked;
+    string error;
+    if (!runScenario(scenario, options, whole, error)) throw runtime_error(error);
+    options.threads = 4;
+    options.chunk_days = 97;
+    if (!runScenario(scenario, options, chunked, error)) throw runtime_error(error);
+    int mismatches = 0;
+    for (int r = 0; r < replications; ++r) {
+        const RunResult& a = whole.replications[r];
+        const RunResult& b = chunked.replications[r];
+        if (a.event_digest != b.event_digest || a.events != b.events || a.seed != b.seed) mismatches++;
+    }
+    return mismatches;
+}
+
+// ------------------- Main -------------------
+
+int main(int argc, char** argv) {
+    bool quick = false;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--quick")) quick = true;
+        else {
+            cerr << "usage: " << argv[0] << " [--quick]\n";
+            return 2;
+        }
+    }
+    const int days = quick ? 730 : 1825;
+    const int seeds = quick ? 2 : 5;
+    const int replications = quick ? 10 : 30;
+    // With this many comparisons a 5-sigma bound keeps false alarms rare
+    // while still catching biased engines
+    const double t_bound = 5.0;
+
+    int failures = 0;
+    for (const Candidate& c : candidates) {
+        for (const GeneratorOptions& f : factories(quick)) {
+            for (const Variant& v : variants()) {
+                string label = c.name + " " + to_string(f.machines) + " machines, overlap "
+                    + (f.overlap == OVERLAP_DISJOINT ? "disjoint" : f.overlap == OVERLAP_NESTED ? "nested" : "random")
+                    + ", " + v.name;
+                bool identical = true;
+                if (c.exact) {
+                    for (int s = 0; s < seeds; ++s) {
+                        int day = firstDivergence(f, v, c, days, 777 + s);
+                        if (day) {
+                            cout << "FAIL  " << label << ": event sequence diverges on day " << day << " (seed " << 777 + s << ")\n";
+                            failures++;
+                            identical = false;
+                        }
+                    }
+                }
+                double t = statisticalDistance(f, v, c, days, replications);
+                bool ok = t <= t_bound;
+                cout << (ok ? "ok    " : "FAIL  ") << label << ": max |t| = " << fixed << setprecision(2) << t
+                    << (c.exact && identical ? ", events identical" : "") << "\n";
+                if (!ok) failures++;
+            }
+        }
+    }
+    for (const GeneratorOptions& f : factories(quick)) {
+        for (const Variant& v : variants()) {
+            int mismatches = schedulingMismatches(f, v, days, seeds * 2);
+            cout << (mismatches ? "FAIL  " : "ok    ") << "chunked on 4 threads " << f.machines << " machines, seed "
+                << f.seed << ", " << v.name << ": " << mismatches << " replication(s) differ\n";
+            if (mismatches) failures++;
+        }
+    }
+    cout << (failures ? to_string(failures) + " check(s) failed\n" : "all checks passed\n");
+    return failures ? 1 : 0;
+}
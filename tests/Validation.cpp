@@ -0,0 +1,212 @@
+// Scenario validation tests: settings that would give meaningless or
+// undefined simulation behaviour must be rejected by validateScenario, and
+// the scenario generator must only write files parseScenario accepts.
+//
+// Build:  cmake --build build --target fmss_validation
+// Run:    ./fmss_validation
+
+#include "../Simulator.h"
+#include "../tools/ScenarioGenerator.h"
+
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const string& what) {
+    cout << (ok ? "ok    " : "FAIL  ") << what << "\n";
+    if (!ok) failures++;
+}
+
+static Scenario baseScenario() {
+    Scenario s;
+    s.addMachineType("lathe", 100, 2, 50);
+    s.addMachineType("press", 50, 5, 10);
+    s.addAdjusterGroup("mechanics", 2, { "lathe", "press" });
+    return s;
+}
+
+// Whether the scenario passes validation after `change`
+template <typename Change>
+static bool valid(Change change) {
+    Scenario s = baseScenario();
+    change(s);
+    string error;
+    return validateScenario(s, error);
+}
+
+int main() {
+    check(valid([](Scenario&) {}), "base scenario is valid");
+
+    // Ageing
+    for (AgeingModel model : { AGEING_KIJIMA_I, AGEING_KIJIMA_II }) {
+        string name = model == AGEING_KIJIMA_I ? "Kijima I" : "Kijima II";
+        auto ageing = [model](double effect) {
+            return [model, effect](Scenario& s) {
+                s.machine_types[0].ageing_model = model;
+                s.machine_types[0].weibull_shape = 2.0;
+                s.machine_types[0].repair_effect = effect;
+            };
+        };
+        check(valid(ageing(0.0)) && valid(ageing(0.5)) && valid(ageing(1.0)), name + ": share of age kept in [0, 1]");
+        check(!valid(ageing(-0.1)), name + ": negative share is rejected");
+        check(!valid(ageing(1.5)), name + ": share above 1 is rejected");
+    }
+    check(!valid([](Scenario& s) { s.machine_types[0].weibull_shape = 0.0; }), "zero Weibull shape is rejected");
+    check(!valid([](Scenario& s) { s.machine_types[0].weibull_shape = NAN; }), "NaN Weibull shape is rejected");
+
+    // On-call groups
+    auto on_call = [](int call_in_queue, int call_in_days, int release_days, double day_rate) {
+        return [=](Scenario& s) {
+            AdjusterGroup& ag = s.adjuster_groups[0];
+            ag.on_call = true;
+            ag.call_in_queue = call_in_queue;
+            ag.call_in_days = call_in_days;
+            ag.release_queue = 0;
+            ag.release_days = release_days;
+            ag.day_rate = day_rate;
+        };
+    };
+    check(valid(on_call(3, 2, 5, 400.0)) && valid(on_call(0, 0, 0, 0.0)), "on-call group with non-negative settings");
+    check(!valid(on_call(-1, 2, 5, 400.0)), "negative call-in threshold is rejected");
+    check(!valid(on_call(3, -2, 5, 400.0)) && !valid(on_call(3, 2, -5, 400.0)), "negative call-in and release days are rejected");
+    check(!valid(on_call(3, 2, 5, -1.0)) && !valid(on_call(3, 2, 5, NAN)) && !valid(on_call(3, 2, 5, INFINITY)),
+        "negative, NaN and infinite day rates are rejected");
+
+    // Zones
+    auto zones = [](double there, double back, double self) {
+        return [there, back, self](Scenario& s) {
+            s.addZone("hall");
+            s.addZone("yard", { there });
+            s.zones[1].travel_hours[0] = back;
+            s.zones[1].travel_hours[1] = self;
+        };
+    };
+    check(valid(zones(2.0, 2.0, 0.0)) && valid(zones(0.0, 3.0, 0.0)), "finite, non-negative travel times");
+    check(!valid(zones(-1.0, 2.0, 0.0)) && !valid(zones(2.0, -1.0, 0.0)), "negative travel times are rejected");
+    check(!valid(zones(NAN, 2.0, 0.0)) && !valid(zones(2.0, INFINITY, 0.0)), "NaN and infinite travel times are rejected");
+    check(!valid(zones(2.0, 2.0, 1.0)), "travel time from a zone to itself must be zero");
+
+    // Team repairs
+    auto crew = [](int max_crew, vector<double> speedup) {
+        return [max_crew, speedup](Scenario& s) {
+            s.machine_types[0].max_crew = max_crew;
+            s.machine_types[0].crew_speedup = speedup;
+        };
+    };
+    check(valid(crew(3, { 1.6, 2.0 })), "a work rate for every crew size above the minimum");
+    check(!valid(crew(3, { 1.6 })) && !valid(crew(3, {})), "missing crew work rates are rejected");
+    check(!valid(crew(2, { 1.6, 2.0 })), "extra crew work rates are rejected");
+    check(!valid(crew(3, { 1.6, 0.0 })) && !valid(crew(3, { -1.0, 2.0 })), "non-positive crew work rates are rejected");
+    check(!valid(crew(3, { NAN, 2.0 })) && !valid(crew(3, { 1.6, INFINITY })), "NaN and infinite crew work rates are rejected");
+
+    // Seasons
+    auto season = [](vector<int> days, vector<double> factor) {
+        return [days, factor](Scenario& s) {
+            s.machine_types[0].season.days = days;
+            s.machine_types[0].season.factor = factor;
+        };
+    };
+    check(valid(season({ 90, 275 }, { 2.0, 0.0 })), "season with a zero-factor segment is valid");
+    check(!valid(season({ 90, 0 }, { 2.0, 1.0 })), "zero-length season segment is rejected");
+    check(!valid(season({ 90, -5 }, { 2.0, 1.0 })), "negative season segment is rejected");
+    check(!valid(season({ 90, 275 }, { 2.0, -1.0 })), "negative season factor is rejected");
+    check(!valid(season({ 90, 275 }, { 0.0, 0.0 })), "all-zero season is rejected");
+    check(!valid(season({ 90, 275 }, { 2.0, NAN })), "NaN season factor is rejected");
+
+    // Shocks and cascades
+    auto shock = [](double probability) {
+        return [probability](Scenario& s) { s.addShockRule(ShockRule("power", 60.0, probability, { "lathe" })); };
+    };
+    check(valid(shock(1.0)) && valid(shock(1e-12)), "shock failure chance in (0, 1]");
+    check(!valid(shock(0.0)) && !valid(shock(1.5)) && !valid(shock(NAN)), "shock failure chance outside (0, 1] is rejected");
+    auto cascade = [](double factor, int days) {
+        return [factor, days](Scenario& s) { s.addCascadeRule(CascadeRule("lathe", "press", factor, days)); };
+    };
+    check(valid(cascade(1.0, 1)) && valid(cascade(3.0, 10)), "cascade with factor >= 1 and duration >= 1");
+    check(!valid(cascade(0.5, 10)), "cascade factor below 1 is rejected");
+    check(!valid(cascade(2.0, 0)), "cascade without a duration is rejected");
+
+    // A hazard factor just above 1 makes the hit probability tiny and the
+    // geometric skips huge; the run must still be well defined
+    Scenario tiny = baseScenario();
+    tiny.machine_types[1].quantity = 5000;
+    tiny.addCascadeRule(CascadeRule("lathe", "press", 1.0 + 1e-13, 1));
+    tiny.addShockRule(ShockRule("flicker", 5.0, 1e-15, { "press" }));
+    RunOptions options;
+    options.days = 3650;
+    options.seed = 9;
+    Results results;
+    string error;
+    check(runScenario(tiny, options, results, error) && results.replications[0].shocks > 0
+        && results.replications[0].shock_failures == 0, "tiny shock and cascade probabilities run cleanly");
+
+    // Each bad run option names itself
+    auto rejects = [&](void (*change)(RunOptions&), const string& what) {
+        RunOptions bad;
+        change(bad);
+        string message;
+        Results ignored;
+        return !runScenario(baseScenario(), bad, ignored, message) && message.find(what) == 0;
+    };
+    check(rejects([](RunOptions& o) { o.days = 0; }, "days") && rejects([](RunOptions& o) { o.replications = 0; }, "replications")
+        && rejects([](RunOptions& o) { o.threads = -1; }, "threads") && rejects([](RunOptions& o) { o.recent_events = -1; }, "recent events")
+        && rejects([](RunOptions& o) { o.chunk_days = -1; }, "chunk days"), "each invalid run option has its own message");
+
+    // Just below a whole number of periods, taking the periods off can round
+    // to a tiny negative remainder
+    IntensityProfile profile;
+    profile.days = { 1, 2 };
+    profile.factor = { 0.3, 0.7 };
+    profile.prepare();
+    bool close = true;
+    for (int n = 1; n < 100000 && close; ++n) {
+        double t = profile.inverse(nextafter(n * profile.period_total, 0.0));
+        double c = profile.cumulative(nextafter(n * profile.period, 0.0));
+        close = fabs(t - n * profile.period) < 1e-6 && fabs(c - n * profile.period_total) < 1e-6;
+    }
+    check(close, "season inversion just below whole periods lands on the period boundary");
+
+    // Generated scenarios read back, down to one type per group
+    const char* pattern_names[] = { "disjoint", "nested", "random" };
+    for (OverlapPattern overlap : { OVERLAP_DISJOINT, OVERLAP_NESTED, OVERLAP_RANDOM }) {
+        bool round_trip = true;
+        for (int groups : { 1, 3, 7 }) {
+            for (int types : { groups, groups + 1, 3 * groups }) {
+                GeneratorOptions opt;
+                opt.types = types;
+                opt.machines = 10 * types;
+                opt.groups = groups;
+                opt.adjusters = 2 * groups;
+                opt.overlap = overlap;
+                opt.overlap_density = 0.0;
+                stringstream text;
+                generateScenario(text, opt);
+                Scenario s;
+                string error;
+                round_trip = round_trip && parseScenario(text, s, error) && (int)s.adjuster_groups.size() == groups;
+            }
+        }
+        check(round_trip, string("generated scenarios parse, ") + pattern_names[overlap] + " overlap");
+    }
+    GeneratorOptions too_few;
+    too_few.types = 2;
+    too_few.machines = 20;
+    too_few.groups = 3;
+    too_few.overlap = OVERLAP_DISJOINT;
+    string generator_error;
+    bool thrown = false;
+    try {
+        stringstream text;
+        generateScenario(text, too_few);
+    }
+    catch (const invalid_argument&) {
+        thrown = true;
+    }
+    check(!validateGeneratorOptions(too_few, generator_error) && thrown, "generator rejects fewer types than groups");
+
+    cout << "\n" << failures << " failure(s)\n";
+    return failures ? 1 : 0;
+}
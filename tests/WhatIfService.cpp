@@ -0,0 +1,310 @@
+// What-if service tests: requests go straight to WhatIfService::handle, no
+// sockets. Checks routing, errors, the analytic model against known queue
+// behaviour, caching, streamed simulation answers, and the fair scheduler's
+// tenant shares, lanes and cancellation.
+//
+// Build:  cmake --build build --target fmss_whatif_test
+// Run:    ./fmss_whatif_test
+
+#include "../server/WhatIfService.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+struct Recorded {
+    int status = 0;
+    string body;                // respond() body, or the last streamed line
+    vector<string> lines;       // streamed lines
+    bool ended = false;
+};
+
+class RecordingResponder : public Responder {
+public:
+    Recorded r;
+    void respond(int status, const string& json) override {
+        r.status = status;
+        r.body = json;
+    }
+    void respondText(int status, const string&, const string& body) override {
+        r.status = status;
+        r.body = body;
+    }
+    bool stream(const string& json_line) override {
+        r.status = 200;
+        r.lines.push_back(json_line);
+        r.body = json_line;
+        return true;
+    }
+    void endStream() override { r.ended = true; }
+};
+
+static HttpRequest makeRequest(const string& method, const string& path, const map<string, string>& query,
+    const string& body, const string& tenant) {
+    HttpRequest request;
+    request.method = method;
+    request.path = path;
+    request.query = query;
+    request.body = body;
+    if (!tenant.empty()) request.headers["x-tenant"] = tenant;
+    return request;
+}
+
+static Recorded call(WhatIfService& service, const string& method, const string& path,
+    const map<string, string>& query = {}, const string& body = "", const string& tenant = "") {
+    RecordingResponder out;
+    service.handle(makeRequest(method, path, query, body, tenant), out);
+    return out.r;
+}
+
+static bool has(const Recorded& r, const string& text) {
+    return r.body.find(text) != string::npos;
+}
+
+static bool anyLine(const Recorded& r, const string& text) {
+    for (const string& line : r.lines) {
+        if (line.find(text) != string::npos) return true;
+    }
+    return false;
+}
+
+static double field(const string& json, const string& name, const string& after = "");
+
+// Cancels its own job as soon as the job line arrives, first as another
+// tenant (refused) and then as the owner
+class CancellingResponder : public RecordingResponder {
+public:
+    WhatIfService& service;
+    int refused = 0, accepted = 0;
+    explicit CancellingResponder(WhatIfService& s) : service(s) {}
+    bool stream(const string& json_line) override {
+        RecordingResponder::stream(json_line);
+        if (r.lines.size() == 1) {
+            string id = to_string((long long)field(json_line, "job"));
+            refused = call(service, "DELETE", "/jobs/" + id, {}, "", "mallory").status;
+            accepted = call(service, "DELETE", "/jobs/" + id, {}, "", "alice").status;
+        }
+        return true;
+    }
+};
+
+// Value of a numeric field after the first occurrence of `after`
+static double field(const string& json, const string& name, const string& after) {
+    size_t from = after.empty() ? 0 : json.find(after);
+    size_t pos = json.find("\"" + name + "\":", from == string::npos ? 0 : from);
+    return pos == string::npos ? -1.0 : atof(json.c_str() + pos + name.size() + 3);
+}
+
+static int failures = 0;
+
+static void check(bool ok, const string& what) {
+    cout << (ok ? "ok    " : "FAIL  ") << what << "\n";
+    if (!ok) failures++;
+}
+
+// One worker, held on the first task while the rest is queued, so the order
+// tasks run in is the scheduler's alone
+static void testScheduler() {
+    FairScheduler scheduler(1);
+    atomic<bool> release{ false };
+    vector<string> order;       // written by the single worker only
+    auto task = [&](const string& who) {
+        return [&, who](int t, const atomic<bool>&) {
+            while (t == 0 && who == "hog" && !release) this_thread::sleep_for(chrono::milliseconds(1));
+            this_thread::sleep_for(chrono::milliseconds(2));
+            order.push_back(who);
+            return false;
+        };
+    };
+    shared_ptr<Job> hog = scheduler.submit("hog", LANE_BATCH, 20, task("hog"));
+    this_thread::sleep_for(chrono::milliseconds(20));
+    shared_ptr<Job> light = scheduler.submit("light", LANE_BATCH, 5, task("light"));
+    shared_ptr<Job> quick = scheduler.submit("hog", LANE_INTERACTIVE, 2, task("quick"));
+    release = true;
+    scheduler.wait(*hog);
+    scheduler.wait(*light);
+    scheduler.wait(*quick);
+
+    size_t last_light = 0, last_quick = 0, first_hog_after = order.size();
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (order[i] == "light") last_light = i;
+        if (order[i] == "quick") last_quick = i;
+    }
+    for (size_t i = 1; i < order.size(); ++i) {
+        if (order[i] == "hog") {
+            first_hog_after = i;
+            break;
+        }
+    }
+    check(order.size() == 27 && last_quick <= 2, "interactive tasks run before queued batch tasks");
+    check(last_light < first_hog_after, "a new tenant is served before the hog's backlog");
+    map<string, TenantStats> stats = scheduler.tenantStats();
+    check(stats["hog"].tasks_completed == 22 && stats["light"].jobs_completed == 1 && stats["hog"].queued_tasks == 0,
+        "per-tenant throughput");
+
+    // A task that returns true gives up its worker between chunks
+    FairScheduler chunked(1);
+    vector<string> trace;
+    int chunks = 0;
+    shared_ptr<Job> long_job = chunked.submit("batch", LANE_BATCH, 1, [&](int, const atomic<bool>&) {
+        this_thread::sleep_for(chrono::milliseconds(2));
+        trace.push_back("chunk");
+        return ++chunks < 10;
+    });
+    this_thread::sleep_for(chrono::milliseconds(5));
+    shared_ptr<Job> short_job = chunked.submit("other", LANE_INTERACTIVE, 1, [&](int, const atomic<bool>&) {
+        trace.push_back("short");
+        return false;
+    });
+    chunked.wait(*long_job);
+    chunked.wait(*short_job);
+    check(trace.size() == 11 && trace.back() == "chunk" && long_job->done == 1,
+        "an interactive job runs between the chunks of a long task");
+
+    // Five sub-tenants of one peer share that peer's half of the worker
+    FairScheduler peers(1);
+    atomic<bool> go{ false };
+    vector<string> served;
+    shared_ptr<Job> blocker = peers.submit("blocker", LANE_BATCH, 1, [&](int, const atomic<bool>&) {
+        while (!go) this_thread::sleep_for(chrono::milliseconds(1));
+        return false;
+    });
+    this_thread::sleep_for(chrono::milliseconds(5));
+    auto serve = [&](const string& who) {
+        return [&, who](int, const atomic<bool>&) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+            served.push_back(who);
+            return false;
+        };
+    };
+    vector<shared_ptr<Job>> split;
+    for (const char* sub : { "a", "b", "c", "d", "e" }) split.push_back(peers.submit("many/" + string(sub), LANE_BATCH, 10, serve("many")));
+    shared_ptr<Job> single = peers.submit("one", LANE_BATCH, 10, serve("one"));
+    go = true;
+    for (auto& job : split) peers.wait(*job);
+    peers.wait(*single);
+    size_t last_one = 0;
+    for (size_t i = 0; i < served.size(); ++i) {
+        if (served[i] == "one") last_one = i;
+    }
+    check(served.size() == 60 && last_one < 25, "sub-tenants split their peer's share instead of adding to it");
+
+    // Idle tenants are forgotten; busy ones are kept
+    FairScheduler forgetful(1, 0.0);
+    forgetful.wait(*forgetful.submit("peer/gone", LANE_BATCH, 1, [](int, const atomic<bool>&) { return false; }));
+    atomic<bool> hold{ false };
+    shared_ptr<Job> held = forgetful.submit("peer/busy", LANE_BATCH, 1, [&](int, const atomic<bool>&) {
+        while (!hold) this_thread::sleep_for(chrono::milliseconds(1));
+        return false;
+    });
+    this_thread::sleep_for(chrono::milliseconds(5));
+    forgetful.wait(*forgetful.submit("other", LANE_INTERACTIVE, 0, nullptr));
+    map<string, TenantStats> kept = forgetful.tenantStats();
+    check(!kept.count("peer/gone") && kept.count("peer/busy") && kept.count("other"), "idle tenants are pruned");
+    hold = true;
+    forgetful.wait(*held);
+}
+
+int main() {
+    ServiceOptions options;
+    options.threads = 2;
+    WhatIfService service(options);
+
+    const string factory =
+        "machine_type lathe 100 2 50\n"
+        "machine_type press 50 5 10\n"
+        "adjuster_group mechanics 2 lathe\n"
+        "adjuster_group electricians 1 press\n";
+    check(call(service, "GET", "/health").status == 200, "health");
+    check(call(service, "PUT", "/scenarios/plant", {}, factory).status == 201, "upload scenario");
+    check(call(service, "PUT", "/scenarios/plant", {}, factory).status == 200, "replace scenario");
+    check(call(service, "PUT", "/scenarios/bad", {}, "machine_type lathe 100\n").status == 422, "malformed scenario is rejected");
+    check(call(service, "PUT", "/scenarios/a%2Fb", {}, factory).status == 400, "bad scenario name is rejected");
+    check(has(call(service, "GET", "/scenarios"), "\"name\":\"plant\""), "scenario list");
+    check(call(service, "GET", "/scenarios/none/analytic").status == 404, "unknown scenario");
+
+    // Mechanics: 0.5 failures/day x 2 days = load 1.0 on 2 adjusters; Erlang C
+    // gives P(wait) = 1/3. Electricians: 0.2 x 5 = load 1.0 on 1, unstable.
+    Recorded base = call(service, "GET", "/scenarios/plant/analytic");
+    check(base.status == 200 && has(base, "\"cached\":false"), "analytic answer");
+    check(fabs(field(base.body, "offered_load") - 1.0) < 1e-9 && fabs(field(base.body, "p_wait") - 1.0 / 3) < 1e-9,
+        "Erlang C for the mechanics");
+    check(has(base, "\"stable\":false"), "overloaded group is unstable");
+    check(has(call(service, "GET", "/scenarios/plant/analytic"), "\"cached\":true"), "repeated query is cached");
+
+    Recorded more = call(service, "GET", "/scenarios/plant/analytic", { { "group", "electricians" }, { "add", "1" } });
+    check(more.status == 200 && fabs(field(more.body, "utilization", "\"id\":\"electricians\"") - 0.5) < 1e-9,
+        "adding an electrician halves their utilization");
+    check(field(more.body, "availability", "press") > field(base.body, "availability", "press"), "and raises press availability");
+    Recorded slower = call(service, "GET", "/scenarios/plant/analytic", { { "type", "lathe" }, { "repair", "4" } });
+    check(fabs(field(slower.body, "offered_load") - 2.0) < 1e-9, "doubling lathe repair time doubles the load");
+
+    check(call(service, "GET", "/scenarios/plant/analytic", { { "group", "welders" }, { "add", "1" } }).status == 400,
+        "unknown group is an error");
+    check(call(service, "GET", "/scenarios/plant/analytic", { { "group", "mechanics" }, { "add", "-2" } }).status == 400,
+        "removing every adjuster is an error");
+    check(call(service, "GET", "/scenarios/plant/analytic", { { "typo", "1" } }).status == 400, "unknown parameter is an error");
+
+    // Simulation: progress lines, then the answer; the baseline is reused
+    map<string, string> query = { { "group", "electricians" }, { "add", "1" }, { "replications", "4" }, { "days", "730" } };
+    Recorded sim = call(service, "GET", "/scenarios/plant/simulate", query);
+    check(sim.ended && has(sim, "\"cached\":false") && sim.lines[0].find("\"lane\":\"interactive\"") != string::npos
+        && anyLine(sim, "\"progress\":8,\"total\":8"), "simulation streams a job line and progress for both scenarios");
+    check(field(sim.body, "mean", "\"whatif\"") >= 0 && field(sim.body, "max_queue_length", "\"delta\"") < 0,
+        "an extra electrician shortens the queue");
+    Recorded again = call(service, "GET", "/scenarios/plant/simulate", query);
+    check(again.lines.size() == 1 && has(again, "\"cached\":true"), "repeated simulation is cached");
+    query["add"] = "2";
+    Recorded other = call(service, "GET", "/scenarios/plant/simulate", query);
+    check(anyLine(other, "\"total\":4") && field(other.body, "mean", "\"baseline\"") == field(sim.body, "mean", "\"baseline\""),
+        "another what-if reuses the cached baseline");
+
+    // Sweep: one point per value, all in one job
+    Recorded sweep = call(service, "GET", "/scenarios/plant/sweep",
+        { { "group", "electricians" }, { "adjusters", "1,2,3" }, { "replications", "2" }, { "lane", "batch" } });
+    check(sweep.ended && sweep.lines[0].find("\"lane\":\"batch\"") != string::npos && anyLine(sweep, "\"total\":6")
+        && field(sweep.body, "value", "\"value\":3") == 3, "sweep runs every point, in the lane asked for");
+    check(field(sweep.body, "mean", "\"value\":3,\"summary\":{\"machine_uptime\"")
+        > field(sweep.body, "mean", "\"value\":1,\"summary\":{\"machine_uptime\""), "more electricians, more uptime");
+    check(call(service, "GET", "/scenarios/plant/sweep", { { "group", "electricians" }, { "adjusters", "1,x" } }).status == 400,
+        "bad sweep value is an error");
+    check(call(service, "GET", "/scenarios/plant/simulate", { { "lane", "fast" } }).status == 400, "unknown lane is an error");
+
+    // Cancelling a long job stops it within a few simulated weeks per worker
+    CancellingResponder canceller(service);
+    auto started = chrono::steady_clock::now();
+    service.handle(makeRequest("GET", "/scenarios/plant/sweep", { { "type", "lathe" }, { "quantity", "100,200" },
+        { "replications", "200" }, { "days", "36500" } }, "", "alice"), canceller);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    check(canceller.refused == 404 && canceller.accepted == 200, "only the owner can cancel a job");
+    check(has(canceller.r, "was cancelled") && seconds < 5.0, "cancelled job ends promptly");
+    Recorded tenants = call(service, "GET", "/tenants");
+    check(field(tenants.body, "jobs_cancelled", "\"local/alice\"") == 1 && field(tenants.body, "queued_tasks", "\"local/alice\"") == 0,
+        "tenant stats count the cancelled job");
+
+    check(call(service, "DELETE", "/scenarios/plant").status == 200, "delete scenario");
+    check(call(service, "GET", "/scenarios/plant/analytic").status == 404, "deleted scenario is gone");
+    check(has(call(service, "GET", "/stats"), "\"analytic\":{\"hits\":1"), "stats count cache hits");
+
+    // Metrics: the workers' slots are summed at scrape
+    Recorded metrics = call(service, "GET", "/metrics");
+    check(metrics.status == 200 && has(metrics, "# TYPE fmss_phase_seconds histogram"), "metrics page");
+    check(has(metrics, "fmss_replications_completed_total 18\n"),
+        "completed replications are counted, cancelled ones are not");
+    check(has(metrics, "fmss_jobs_total{outcome=\"cancelled\"} 1\n") && has(metrics, "fmss_jobs_pending 0\n"), "job counts");
+    check(has(metrics, "fmss_cache_hit_ratio{cache=\"analytic\"} 0.25\n"), "cache hit ratio");
+    check(has(metrics, "fmss_phase_seconds_count{phase=\"replication\"} 18\n")
+        && has(metrics, "fmss_phase_seconds_bucket{phase=\"replication\",le=\"+Inf\"} 18\n"), "replication latency histogram");
+    check(!has(metrics, "process_resident_memory_bytes 0\n"), "process memory");
+    // Scraping is read-only: a second scraper sees the same event counter
+    size_t at = metrics.body.find("\nfmss_simulated_events_total ");
+    string events_line = at == string::npos ? "" : metrics.body.substr(at, metrics.body.find('\n', at + 1) - at + 1);
+    check(!events_line.empty() && events_line != "\nfmss_simulated_events_total 0\n"
+        && has(call(service, "GET", "/metrics"), events_line.substr(1)), "event counter is left alone by scrapes");
+
+    testScheduler();
+
+    cout << "\n" << failures << " failure(s)\n";
+    return failures ? 1 : 0;
+}
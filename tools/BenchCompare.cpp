@@ -0,0 +1,249 @@
+// Compares two benchmark result files (baseline and candidate) written by
+// bench/Benchmark.cpp and reports the speedup or slowdown of each benchmark.
+//
+// Build:  cmake --build build --target fmss_benchcompare
+// Run:    ./fmss_benchcompare [--threshold PCT] [--alpha P] baseline.jsonl candidate.jsonl
+//
+// A change counts only when it is both larger than the threshold (default
+// 5%) and significant: a one-sided Mann-Whitney U test on the per-repetition
+// samples must reject "no difference" at level alpha (default 0.05). The test
+// is rank-based, so a single outlier repetition cannot make a change look
+// significant. Exits 1 when any benchmark got significantly slower by more
+// than the threshold.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// ------------------- Result files -------------------
+
+struct BenchRecord {
+    string key;                 // benchmark name, plus the factory if any
+    string unit;
+    vector<double> samples;     // all repetitions; repeated keys are merged
+};
+
+// Reads the flat JSON objects the benchmark prints: string and number
+// values plus the "samples" array. Returns false on malformed lines.
+static bool parseRecord(const string& line, BenchRecord& rec) {
+    map<string, string> fields;
+    vector<double> samples;
+    size_t i = 0, n = line.size();
+    auto skipSpace = [&]() { while (i < n && isspace((unsigned char)line[i])) ++i; };
+    auto readString = [&](string& out) {
+        if (i >= n || line[i] != '"') return false;
+        size_t end = line.find('"', i + 1);
+        if (end == string::npos) return false;
+        out = line.substr(i + 1, end - i - 1);
+        i = end + 1;
+        return true;
+    };
+    skipSpace();
+    if (i >= n || line[i++] != '{') return false;
+    while (true) {
+        skipSpace();
+        string name;
+        if (!readString(name)) return false;
+        skipSpace();
+        if (i >= n || line[i++] != ':') return false;
+        skipSpace();
+        if (i < n && line[i] == '"') {
+            if (!readString(fields[name])) return false;
+        }
+        else if (i < n && line[i] == '[') {
+            ++i;
+            while (true) {
+                skipSpace();
+                if (i < n && line[i] == ']') { ++i; break; }
+                char* end;
+                double v = strtod(line.c_str() + i, &end);
+                if (end == line.c_str() + i) return false;
+                if (name == "samples") samples.push_back(v);
+                i = end - line.c_str();
+                skipSpace();
+                if (i < n && line[i] == ',') ++i;
+            }
+        }
+        else {
+            size_t start = i;
+            while (i < n && line[i] != ',' && line[i] != '}') ++i;
+            fields[name] = line.substr(start, i - start);
+        }
+        skipSpace();
+        if (i < n && line[i] == ',') { ++i; continue; }
+        if (i < n && line[i] == '}') break;
+        return false;
+    }
+    if (!fields.count("bench") || samples.empty()) return false;
+    rec.key = fields["bench"];
+    if (fields.count("factory")) rec.key += "/" + fields["factory"];
+    rec.unit = fields["unit"];
+    rec.samples = samples;
+    return true;
+}
+
+// Results by key in file order; blank lines and lines not starting with '{'
+// (progress output, comments) are skipped
+static bool loadResults(const string& path, vector<BenchRecord>& results) {
+    ifstream file(path);
+    if (!file) {
+        cerr << "cannot open " << path << "\n";
+        return false;
+    }
+    map<string, size_t> index;
+    string line;
+    int line_no = 0;
+    while (getline(file, line)) {
+        ++line_no;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == string::npos || line[first] != '{') continue;
+        BenchRecord rec;
+        if (!parseRecord(line, rec)) {
+            cerr << path << ":" << line_no << ": not a benchmark result\n";
+            return false;
+        }
+        auto it = index.find(rec.key);
+        if (it == index.end()) {
+            index[rec.key] = results.size();
+            results.push_back(rec);
+        }
+        else {
+            vector<double>& s = results[it->second].samples;
+            s.insert(s.end(), rec.samples.begin(), rec.samples.end());
+        }
+    }
+    return true;
+}
+
+// ------------------- Statistics -------------------
+
+static double median(vector<double> v) {
+    sort(v.begin(), v.end());
+    size_t n = v.size();
+    return n % 2 ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+}
+
+// Mann-Whitney U of b against a: pairs where b is larger, ties count half
+static double mannWhitneyU(const vector<double>& a, const vector<double>& b) {
+    double u = 0.0;
+    for (double y : b) {
+        for (double x : a) u += y > x ? 1.0 : y == x ? 0.5 : 0.0;
+    }
+    return u;
+}
+
+// P(U >= u) under the null hypothesis for sample sizes m and n, from the
+// exact distribution of U (counts of rank arrangements, built up one
+// observation at a time). Sizes here are a handful of repetitions.
+static double upperTail(int m, int n, double u) {
+    // ways[i][j][k]: arrangements of i a-values and j b-values with U = k
+    vector<vector<vector<double>>> ways(m + 1, vector<vector<double>>(n + 1));
+    for (int i = 0; i <= m; ++i) {
+        for (int j = 0; j <= n; ++j) {
+            ways[i][j].assign(i * j + 1, 0.0);
+            if (i == 0 || j == 0) {
+                ways[i][j][0] = 1.0;
+                continue;
+            }
+            // The largest value is either a b-value (above all i a-values) or an a-value
+            for (int k = 0; k <= i * j; ++k) {
+                if (k >= i && k - i <= i * (j - 1)) ways[i][j][k] += ways[i][j - 1][k - i];
+                if (k <= (i - 1) * j) ways[i][j][k] += ways[i - 1][j][k];
+            }
+        }
+    }
+    const vector<double>& dist = ways[m][n];
+    double total = 0.0, tail = 0.0;
+    for (size_t k = 0; k < dist.size(); ++k) {
+        total += dist[k];
+        if (k + 1e-9 >= u) tail += dist[k];
+    }
+    return tail / total;
+}
+
+// ------------------- Main -------------------
+
+static void usage(const char* prog) {
+    cerr << "usage: " << prog << " [options] baseline.jsonl candidate.jsonl\n"
+        << "  --threshold PCT         smallest change that counts, in percent (default 5)\n"
+        << "  --alpha P               significance level of the U test (default 0.05)\n"
+        << "  --filter TEXT           only compare benchmarks whose name contains TEXT\n";
+}
+
+int main(int argc, char** argv) {
+    double threshold = 5.0, alpha = 0.05;
+    string filter;
+    vector<string> paths;
+    bool ok = true;
+    for (int i = 1; i < argc && ok; ++i) {
+        int left = argc - i - 1;
+        if (!strcmp(argv[i], "--threshold") && left >= 1) threshold = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--alpha") && left >= 1) alpha = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--filter") && left >= 1) filter = argv[++i];
+        else if (argv[i][0] != '-') paths.push_back(argv[i]);
+        else ok = false;
+    }
+    ok = ok && paths.size() == 2 && threshold >= 0 && alpha > 0 && alpha < 1;
+    if (!ok) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    vector<BenchRecord> baseline, candidate;
+    if (!loadResults(paths[0], baseline) || !loadResults(paths[1], candidate)) return 2;
+    map<string, const BenchRecord*> by_key;
+    for (const BenchRecord& r : candidate) by_key[r.key] = &r;
+
+    int slower = 0, faster = 0, inconclusive = 0, missing = 0;
+    size_t width = 10;
+    for (const BenchRecord& b : baseline) width = max(width, b.key.size());
+    cout << left << setw((int)width) << "benchmark" << right << setw(14) << "baseline" << setw(14) << "candidate"
+        << setw(10) << "change" << setw(9) << "p" << "  verdict\n";
+    for (const BenchRecord& b : baseline) {
+        if (!filter.empty() && b.key.find(filter) == string::npos) continue;
+        auto it = by_key.find(b.key);
+        if (it == by_key.end()) {
+            cout << left << setw((int)width) << b.key << "  missing from candidate\n";
+            missing++;
+            continue;
+        }
+        const BenchRecord& c = *it->second;
+        double base = median(b.samples), cand = median(c.samples);
+        double change = base > 0 ? 100.0 * (cand - base) / base : 0.0;
+        int m = (int)b.samples.size(), n = (int)c.samples.size();
+        double u = mannWhitneyU(b.samples, c.samples);
+        // Times: a larger candidate is slower. One-sided in the direction of the change.
+        double p = change >= 0 ? upperTail(m, n, u) : upperTail(n, m, (double)m * n - u);
+        // The smallest p-value these sample sizes can reach; above alpha no
+        // change can ever be significant
+        double best_p = upperTail(m, n, (double)m * n);
+
+        string verdict = "same";
+        if (fabs(change) > threshold) {
+            if (p <= alpha) {
+                verdict = change > 0 ? "SLOWER" : "faster";
+                (change > 0 ? slower : faster)++;
+            }
+            else {
+                verdict = best_p > alpha ? "too few samples" : "noise";
+                inconclusive++;
+            }
+        }
+        if (b.unit != c.unit) verdict += " (units differ: " + b.unit + " vs " + c.unit + ")";
+        cout << left << setw((int)width) << b.key << right << fixed << setprecision(1) << setw(14) << base << setw(14) << cand
+            << setw(9) << showpos << change << "%" << noshowpos << setprecision(3) << setw(9) << p << "  " << verdict << "\n";
+    }
+    cout << "\n" << slower << " slower, " << faster << " faster, " << inconclusive << " inconclusive";
+    if (missing) cout << ", " << missing << " missing";
+    cout << " (threshold " << setprecision(1) << threshold << "%, alpha " << setprecision(3) << alpha << ")\n";
+    return slower ? 1 : 0;
+}
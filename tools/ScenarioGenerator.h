@@ -0,0 +1,131 @@
+// Synthetic factory scenarios for scaling studies and benchmarks.
+//
+// generateScenario() writes a scenario in the text format read by
+// parseScenario(). All randomness comes from mt19937 raw output
+// with our own conversions (the std:: distributions differ between standard
+// libraries), so a seed gives the same scenario on every compiler and build.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// How adjuster group capabilities overlap
+enum OverlapPattern {
+    OVERLAP_DISJOINT,   // every machine type belongs to exactly one group
+    OVERLAP_NESTED,     // group g services the first (g+1)/groups of the types
+    OVERLAP_RANDOM      // each group services each type with a fixed chance
+};
+
+struct GeneratorOptions {
+    unsigned seed = 1;
+    int types = 10;             // machine types
+    int machines = 1000;        // machines over all types
+    double fleet_skew = 0.0;    // 0 = equal fleets, >0 = Zipf-like skew towards the first types
+    int mttf_min = 30;          // MTTF range (days), drawn log-uniformly
+    int mttf_max = 365;
+    int repair_min = 1;         // repair time range (days), drawn log-uniformly
+    int repair_max = 10;
+    int groups = 3;             // adjuster groups
+    int adjusters = 10;         // adjusters over all groups
+    OverlapPattern overlap = OVERLAP_RANDOM;
+    double overlap_density = 0.5;   // chance per (group, type) for OVERLAP_RANDOM
+};
+
+class ScenarioRandom {
+private:
+    std::mt19937 gen;
+
+public:
+    explicit ScenarioRandom(unsigned seed) : gen(seed) {}
+
+    double unit() { return gen() / 4294967296.0; }
+
+    int uniformInt(int lo, int hi) {
+        return lo + std::min((int)(unit() * (hi - lo + 1)), hi - lo);
+    }
+
+    int logUniformInt(int lo, int hi) {
+        double v = std::exp(std::log((double)lo) + unit() * (std::log((double)hi + 1.0) - std::log((double)lo)));
+        return std::min(std::max((int)v, lo), hi);
+    }
+};
+
+// Split total into n shares, weighted 1/(i+1)^skew, each at least 1
+inline std::vector<int> splitCounts(int total, int n, double skew) {
+    std::vector<double> weight(n);
+    double sum = 0.0;
+    for (int i = 0; i < n; ++i) {
+        weight[i] = 1.0 / std::pow(i + 1.0, skew);
+        sum += weight[i];
+    }
+    std::vector<int> counts(n, 1);
+    int left = std::max(total - n, 0);
+    int given = 0;
+    for (int i = 0; i < n; ++i) {
+        int share = (int)(left * weight[i] / sum);
+        counts[i] += share;
+        given += share;
+    }
+    for (int i = 0; given < left; i = (i + 1) % n, ++given) counts[i]++;
+    return counts;
+}
+
+// Whether the options describe a factory parseScenario will accept. Every
+// group needs a machine type of its own, so there must be at least as many
+// types as groups.
+inline bool validateGeneratorOptions(const GeneratorOptions& opt, std::string& error) {
+    if (opt.types < 1 || opt.machines < opt.types) error = "need at least one type and one machine per type";
+    else if (opt.groups < 1 || opt.adjusters < opt.groups) error = "need at least one group and one adjuster per group";
+    else if (opt.types < opt.groups) error = "need at least as many machine types as adjuster groups";
+    else if (opt.mttf_min < 1 || opt.mttf_max < opt.mttf_min) error = "bad MTTF range";
+    else if (opt.repair_min < 1 || opt.repair_max < opt.repair_min) error = "bad repair time range";
+    else if (!(opt.fleet_skew >= 0)) error = "fleet skew must not be negative";
+    else if (!(opt.overlap_density >= 0 && opt.overlap_density <= 1)) error = "overlap density must be between 0 and 1";
+    else return true;
+    return false;
+}
+
+inline void generateScenario(std::ostream& out, const GeneratorOptions& opt) {
+    static const char* pattern_names[] = { "disjoint", "nested", "random" };
+    std::string error;
+    if (!validateGeneratorOptions(opt, error)) throw std::invalid_argument("scenario generator: " + error);
+    ScenarioRandom rnd(opt.seed);
+
+    out << "# FMSS scenario: seed " << opt.seed << ", " << opt.types << " machine types, " << opt.machines
+        << " machines, " << opt.groups << " adjuster groups, " << opt.adjusters << " adjusters, "
+        << pattern_names[opt.overlap] << " overlap\n";
+
+    std::vector<int> fleet = splitCounts(opt.machines, opt.types, opt.fleet_skew);
+    for (int t = 0; t < opt.types; ++t) {
+        int mttf = rnd.logUniformInt(opt.mttf_min, opt.mttf_max);
+        int repair = rnd.logUniformInt(opt.repair_min, opt.repair_max);
+        out << "machine_type type" << t << " " << mttf << " " << repair << " " << fleet[t] << "\n";
+    }
+
+    std::vector<int> staff = splitCounts(opt.adjusters, opt.groups, 0.0);
+    for (int g = 0; g < opt.groups; ++g) {
+        out << "adjuster_group group" << g << " " << staff[g];
+        for (int t = 0; t < opt.types; ++t) {
+            bool capable;
+            if (opt.overlap == OVERLAP_DISJOINT) {
+                capable = t % opt.groups == g;
+            }
+            else if (opt.overlap == OVERLAP_NESTED) {
+                capable = (long long)t * opt.groups < (long long)(g + 1) * opt.types;
+            }
+            else {
+                // Type t always keeps group t % groups so nothing is left unserviced
+                capable = rnd.unit() < opt.overlap_density || t % opt.groups == g;
+            }
+            if (capable) out << " type" << t;
+        }
+        out << "\n";
+    }
+}